@@ -4,6 +4,8 @@ struct file;
 struct inode;
 struct pipe;
 struct proc;
+struct rb_node;
+struct rb_root;
 struct spinlock;
 struct sleeplock;
 struct stat;
@@ -83,6 +85,8 @@ void            printfinit(void);
 
 // proc.c
 int             cpuid(void);
+void            resched_cpu(int);
+int             need_resched(void);
 void            exit(int);
 int             fork(void);
 int             growproc(int);
@@ -106,10 +110,57 @@ int             either_copyout(int user_dst, uint64 dst, void *src, uint64 len);
 int             either_copyin(void *dst, int user_src, uint64 src, uint64 len);
 void            procdump(void);
 int             trace(int, int);
-void            update_process_times(void);
 int             wait_stat(uint64, uint64);
 int             set_priority(int);
 void            set_debug_mode(int);
+int             set_policy(int, int);
+int             set_deadline(int, int, int);
+int             cpustat(uint64, int);
+int             set_affinity(int, uint64);
+int             get_affinity(int, uint64);
+int             set_timeslice(int, int);
+int             get_timeslice(int);
+void            cpugroupinit(void);
+void            cpugroup_charge(struct proc*, uint64);
+int             cpugroup_tick(struct proc*);
+int             cpugroup_park(struct proc*);
+void            cpugroup_refill(void);
+void            cpugroup_fork(struct proc*, struct proc*);
+int             cpugroup_leave(struct proc*);
+int             cpugroup_join(int, int);
+int             cpugroup_create(int, int);
+int             cpugroup_stat(int, uint64);
+
+// rbtree.c
+void            rb_init(struct rb_root*);
+struct rb_node* rb_first(struct rb_root*);
+struct rb_node* rb_next(struct rb_node*);
+void            rb_insert(struct rb_root*, struct rb_node*);
+void            rb_erase(struct rb_root*, struct rb_node*);
+
+// sched.c
+void            schedinit(void);
+int             sched_set_default(int);
+void            sched_enqueue(struct proc*);
+void            sched_requeue(struct proc*);
+struct proc*    sched_pick_next(void);
+int             sched_tick(struct proc*);
+void            sched_balance(void);
+void            sched_age(void);
+int             sched_edf_admit(struct proc*, int, int);
+void            sched_edf_release(struct proc*);
+void            edf_new_job(struct proc*);
+int             sched_policy_of(struct proc*);
+void            sched_proc_init(struct proc*);
+void            sched_burst_end(struct proc*, uint64);
+uint64          sched_timeslice(struct proc*);
+
+// schedtrace.c
+void            schedtraceinit(void);
+void            sched_trace_event(struct proc*, int, int);
+void            sched_trace_state(struct proc*, int);
+int             sched_trace(int);
+int             sched_trace_read(uint64, int);
 
 // swtch.S
 void            swtch(struct context*, struct context*);
@@ -151,6 +202,7 @@ void            trapinit(void);
 void            trapinithart(void);
 extern struct spinlock tickslock;
 void            usertrapret(void);
+void            set_slice_timer(uint64);
 
 // uart.c
 void            uartinit(void);
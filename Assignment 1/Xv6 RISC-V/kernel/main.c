@@ -20,6 +20,9 @@ main()
     kvminit();       // create kernel page table
     kvminithart();   // turn on paging
     procinit();      // process table
+    cpugroupinit();  // CPU bandwidth groups
+    schedinit();     // scheduler run queues
+    schedtraceinit(); // scheduler event trace
     trapinit();      // trap vectors
     trapinithart();  // install kernel trap vector
     plicinit();      // set up interrupt controller
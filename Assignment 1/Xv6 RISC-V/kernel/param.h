@@ -1,5 +1,9 @@
+#ifndef NPROC
 #define NPROC 64                  // maximum number of processes
+#endif
+#ifndef NCPU
 #define NCPU 8                    // maximum number of CPUs
+#endif
 #define NOFILE 16                 // open files per process
 #define NFILE 100                 // open files per system
 #define NINODE 50                 // maximum number of active i-nodes
@@ -11,8 +15,26 @@
 #define NBUF (MAXOPBLOCKS * 3)    // size of disk block cache
 #define FSSIZE 1000               // size of file system in blocks
 #define MAXPATH 128               // maximum file path name
-#define QUANTUM 5                 // size of clock tick
+#ifndef QUANTUM
+#define QUANTUM 5                 // timeslice of a Normal_Priority process, in ticks
+#endif
+#define TIMER_INTERVAL 1000000    // r_time() units between timer interrupts
+#define TIME_PER_US 10            // r_time() units per microsecond on qemu virt
+#ifndef ALPHA
 #define ALPHA 50                  // alpha burst approximation
+#endif
+#define MIN_TIMESLICE 100         // shortest timeslice sched_settimeslice() sets, in microseconds
+#define MAX_TIMESLICE 10000000    // longest timeslice sched_settimeslice() sets, in microseconds
+#define MLFQ_LEVELS 4             // MLFQ levels, level i runs for timeslice << i
+#define MLFQ_BOOST 100            // ticks between MLFQ priority boosts
+#define BALANCE_INTERVAL 10       // ticks between load balancer runs
+#define BALANCE_PCT 25            // load imbalance in percent the balancer tolerates
+#ifndef MAX_WAIT
+#define MAX_WAIT 50               // ticks a SRT or CFSD process waits at most to run
+#endif
+#define AGE_INTERVAL (MAX_WAIT / 5 + 1) // ticks between aging passes
+#define TRACE_SIZE 1024           // scheduler trace records buffered per hart
+#define NGROUP 16                 // maximum number of CPU bandwidth groups
 #define INT_MAX 2147483647        // max int value
 #define Test_High_Priority 1      // test high priority decay factory value
 #define High_Priority 3           // high priority decay factory value
@@ -3,7 +3,9 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "rbtree.h"
 #include "proc.h"
+#include "sched.h"
 #include "defs.h"
 
 struct cpu cpus[NCPU];
@@ -26,83 +28,59 @@ extern char trampoline[]; // trampoline.S
 // must be acquired before any p->lock.
 struct spinlock wait_lock;
 
-// ------------------- QUEUE -------------------
-// A structure to represent a queue
-struct Queue
-{
-    int front, rear, size;
-    unsigned capacity;
-    struct proc *array[NPROC];
-};
-
 int debug_mode = 0;
-struct Queue queue;
-struct spinlock queue_lock;
-// function to create a queue
-// It initializes size of queue as 0
-void initQueue()
-{
-    acquire(&queue_lock);
-    queue.capacity = NPROC;
-    queue.front = 0;
-    queue.size = 0;
-    queue.rear = queue.capacity - 1;
-    for (int i = 0; i < queue.capacity; i++) // clear array
-    {
-        queue.array[i] = 0;
-    }
-    release(&queue_lock);
-}
 
-// Queue is full when size becomes
-// equal to the capacity
-// IMPORTANT: Do Not Use queue_lock
-int isFull(struct Queue *queue)
-{
-    return (queue->size == queue->capacity);
-}
-
-// Queue is empty when size is 0
-// IMPORTANT: Do Not Use queue_lock
-int isEmpty(struct Queue *queue)
+// Switch p to a new state, charging the ticks since its last
+// state change to the time counters of the state it leaves,
+// and record the change in the scheduler trace.
+// Times are accounted only here, so the timer interrupt
+// doesn't have to visit every process on each tick.
+// Reads ticks without tickslock, since clockintr() takes
+// p->lock while holding tickslock.
+// CPU bursts are measured with the time CSR rather than in
+// ticks, so a burst shorter than a tick doesn't count as zero.
+// p->lock must be held.
+void set_state(struct proc *p, enum procstate state)
 {
-    return (queue->size == 0);
-}
+    uint now = ticks;
+    int delta = now - p->state_tick;
+    enum procstate old = p->state;
 
-// Function to add an item to the queue.
-// It changes rear and size
-void enqueue(struct Queue *queue, struct proc *item)
-{
-    acquire(&queue_lock);
-    if (isFull(queue))
+    if (p->state == SLEEPING)
     {
-        release(&queue_lock);
-        return;
+        p->performance.stime += delta;
     }
-    queue->rear = (queue->rear + 1) % queue->capacity;
-    queue->array[queue->rear] = item;
-    queue->size = queue->size + 1;
-    release(&queue_lock);
-}
-
-// Function to remove an item from queue.
-// It changes front and size
-struct proc *dequeue(struct Queue *queue)
-{
-    acquire(&queue_lock);
-    if (isEmpty(queue))
+    else if (p->state == RUNNABLE)
     {
-        release(&queue_lock);
-        return 0;
+        p->performance.retime += delta;
+    }
+    else if (p->state == RUNNING)
+    {
+        uint64 end = r_time();
+        p->performance.rutime += delta;
+        sched_burst_end(p, end - p->run_start);
+        cpugroup_charge(p, end);
     }
-    struct proc *item = queue->array[queue->front];
-    queue->front = (queue->front + 1) % queue->capacity;
-    queue->size = queue->size - 1;
-    release(&queue_lock);
 
-    return item;
+    if (state == RUNNING)
+        p->run_start = r_time();
+    p->state_tick = now;
+    p->state = state;
+    sched_trace_state(p, old);
+}
+
+// Mark p RUNNABLE and hand it to the run queue of its policy, or
+// park it if its CPU bandwidth group is throttled.
+// Every transition to RUNNABLE goes through here (userinit, fork,
+// yield, wakeup and kill), so the run queues are fed by the state
+// changes themselves and never need a rescan of proc[].
+// p->lock must be held.
+void make_runnable(struct proc *p)
+{
+    set_state(p, RUNNABLE);
+    if (!cpugroup_park(p))
+        sched_enqueue(p);
 }
-// ------------------- END OF QUEUE -------------------
 
 // Allocate a page for each process's kernel stack.
 // Map it high in memory, followed by an invalid
@@ -154,6 +132,31 @@ mycpu(void)
     return c;
 }
 
+// Ask cpu to call the scheduler as soon as it can: at its next
+// trap return if it runs a process, at once if it is idle. Another
+// CPU gets a reschedule IPI, a CLINT software interrupt that timervec
+// in kernelvec.S passes on as a supervisor software interrupt.
+// Interrupts must be disabled.
+void resched_cpu(int cpu)
+{
+    cpus[cpu].need_resched = 1;
+    if (cpu != cpuid())
+    {
+        // the flag must be visible before the interrupt arrives.
+        __sync_synchronize();
+        *(uint32 *)CLINT_MSIP(cpu) = 1;
+    }
+}
+
+// Whether this CPU has been asked to reschedule.
+int need_resched(void)
+{
+    push_off();
+    int resched = mycpu()->need_resched;
+    pop_off();
+    return resched;
+}
+
 // Return the current struct proc *, or zero if none.
 struct proc *
 myproc(void)
@@ -179,15 +182,17 @@ int allocpid()
 
 void init_performance(struct perf *pt)
 {
-    acquire(&tickslock);
     pt->ctime = ticks;
-    release(&tickslock);
     pt->ttime = -1;
     pt->stime = 0;
     pt->retime = 0;
     pt->rutime = 0;
     pt->bursttime = 0;
-    pt->average_bursttime = QUANTUM * 100;
+    pt->average_bursttime = QUANTUM * TIMER_INTERVAL / TIME_PER_US;
+    pt->deadline_misses = 0;
+    pt->overruns = 0;
+    pt->migrations = 0;
+    pt->starvations = 0;
 }
 
 void free_performance(struct perf *pt)
@@ -199,31 +204,10 @@ void free_performance(struct perf *pt)
     pt->rutime = 0;
     pt->bursttime = 0;
     pt->average_bursttime = 0;
-}
-
-void update_process_times(void)
-{
-    struct proc *p;
-    for (p = proc; p < &proc[NPROC]; p++)
-    {
-        acquire(&p->lock);
-        if (p->state == SLEEPING)
-        {
-            p->performance.stime++;
-        }
-        else if (p->state == RUNNABLE)
-        {
-            p->performance.retime++;
-        }
-        else if (p->state == RUNNING)
-        {
-            p->performance.rutime++;
-        }
-
-        p->performance.average_bursttime = ALPHA * p->performance.bursttime - (((100 - ALPHA) * p->performance.average_bursttime) / 100);
-
-        release(&p->lock);
-    }
+    pt->deadline_misses = 0;
+    pt->overruns = 0;
+    pt->migrations = 0;
+    pt->starvations = 0;
 }
 
 // Look in the process table for an UNUSED proc.
@@ -251,7 +235,7 @@ allocproc(void)
 
 found:
     p->pid = allocpid();
-    p->state = USED;
+    set_state(p, USED);
 
     // Allocate a trapframe page.
     if ((p->trapframe = (struct trapframe *)kalloc()) == 0)
@@ -278,7 +262,11 @@ found:
 
     p->mask = 0;
     init_performance(&p->performance);
-    p->priority = Normal_Priority;
+    sched_proc_init(p);
+    p->group = 0;
+    p->group_mark = 0;
+    p->group_next = 0;
+    p->group_parked = 0;
 
     return p;
 }
@@ -304,9 +292,29 @@ freeproc(struct proc *p)
     p->xstate = 0;
     p->state = UNUSED;
 
+    // exit() has left the group already, unless p never ran.
+    cpugroup_leave(p);
     p->mask = 0;
     free_performance(&p->performance);
     p->priority = 0;
+    p->vruntime = 0;
+    p->burst_avg = 0;
+    p->policy = SCHED_SYSTEM;
+    p->sched_class = 0;
+    p->rq_cpu = -1;
+    p->mlfq_level = 0;
+    p->mlfq_epoch = 0;
+    p->pass = 0;
+    p->edf_runtime = 0;
+    p->edf_period = 0;
+    p->edf_deadline = 0;
+    p->edf_bw = 0;
+    p->edf_budget = 0;
+    p->edf_abs_deadline = 0;
+    p->edf_period_end = 0;
+    p->edf_missed = 0;
+    p->affinity = ~0UL;
+    p->last_cpu = -1;
 }
 
 // Create a user page table for a given process,
@@ -384,11 +392,11 @@ void userinit(void)
     safestrcpy(p->name, "initcode", sizeof(p->name));
     p->cwd = namei("/");
 
-    p->state = RUNNABLE;
-
     p->mask = 0;
     init_performance(&p->performance);
 
+    make_runnable(p);
+
     release(&p->lock);
 }
 
@@ -460,20 +468,21 @@ int fork(void)
     np->parent = p;
     release(&wait_lock);
 
-    acquire(&np->lock);
-    np->state = RUNNABLE;
-    release(&np->lock);
-
     acquire(&p->lock);
     acquire(&np->lock);
     np->mask = p->mask;
     np->priority = p->priority;
+    np->timeslice = p->timeslice;
+    np->affinity = p->affinity;
+    cpugroup_fork(p, np);
+    // the child has no EDF reservation of its own.
+    np->policy = p->policy == SCHED_EDF ? SCHED_SYSTEM : p->policy;
     release(&np->lock);
     release(&p->lock);
 
-#ifdef FCFS
-    enqueue(&queue, np);
-#endif
+    acquire(&np->lock);
+    make_runnable(np);
+    release(&np->lock);
 
     return pid;
 }
@@ -520,6 +529,8 @@ void exit(int status)
     end_op();
     p->cwd = 0;
 
+    sched_edf_release(p);
+
     acquire(&wait_lock);
 
     // Give any children to init.
@@ -531,11 +542,9 @@ void exit(int status)
     acquire(&p->lock);
 
     p->xstate = status;
-    p->state = ZOMBIE;
-
-    acquire(&tickslock);
+    set_state(p, ZOMBIE);
+    cpugroup_leave(p);
     p->performance.ttime = ticks;
-    release(&tickslock);
 
     release(&wait_lock);
 
@@ -598,214 +607,110 @@ int wait(uint64 addr)
     }
 }
 
-void default_policy_scheduler(void)
+// Stop the hart until an interrupt arrives, and count
+// the time it waited as idle time.
+// Must be called with interrupts off.
+static void cpu_idle(struct cpu *c)
 {
-    struct proc *p;
-    struct cpu *c = mycpu();
-
-    c->proc = 0;
-
-    for (p = proc; p < &proc[NPROC]; p++)
-    {
-        acquire(&p->lock);
-        if (p->state == RUNNABLE)
-        {
-            // Switch to chosen process.  It is the process's job
-            // to release its lock and then reacquire it
-            // before jumping back to us.
-            p->state = RUNNING;
-            c->proc = p;
-            swtch(&c->context, &p->context);
-
-            // Process is done running for now.
-            // It should have changed its p->state before coming back.
-            c->proc = 0;
-        }
-        release(&p->lock);
-    }
+    c->idle_start = r_time();
+    wfi();
+    c->idle += r_time() - c->idle_start;
+    c->idle_start = 0;
 }
 
-// initialize queue with all runnable processes
-void init_FCFS_policy(void)
+// Idle time of c up to now, including a wait in progress.
+// Reads another hart's counters without a lock, which is
+// good enough for statistics.
+static uint64 cpu_idle_time(struct cpu *c, uint64 now)
 {
-    initQueue();
-    struct proc *p;
+    uint64 idle_start = c->idle_start;
+    uint64 idle = c->idle;
 
-    for (p = proc; p < &proc[NPROC]; p++)
-    {
-        acquire(&p->lock);
-        if (p->state == RUNNABLE)
-        {
-            enqueue(&queue, p);
-        }
-        release(&p->lock);
-    }
+    if (idle_start != 0 && now > idle_start)
+        idle += now - idle_start;
+    return idle;
 }
 
-void FCFS_policy_scheduler(void)
+// Mask of the harts that have started scheduling.
+static uint64 online_cpus(void)
 {
-    struct proc *p;
-    struct cpu *c = mycpu();
-
-    c->proc = 0;
-
-    p = dequeue(&queue);
+    uint64 mask = 0;
 
-    if (p != 0)
-    {
-        acquire(&p->lock);
-        if (p->state == RUNNABLE)
-        {
-            // Switch to chosen process.  It is the process's job
-            // to release its lock and then reacquire it
-            // before jumping back to us.
-            p->state = RUNNING;
-            c->proc = p;
-            swtch(&c->context, &p->context);
-
-            // Process is done running for now.
-            // It should have changed its p->state before coming back.
-            c->proc = 0;
-        }
-        release(&p->lock);
-    }
+    for (int i = 0; i < NCPU; i++)
+        if (cpus[i].start != 0)
+            mask |= 1UL << i;
+    return mask;
 }
 
-void SRT_policy_scheduler(void)
+// Per-CPU process scheduler.
+// Each CPU calls scheduler() after setting itself up.
+// Scheduler never returns.  It loops, doing:
+//  - choose a process to run, see sched_pick_next().
+//  - swtch to start running that process.
+//  - eventually that process transfers control
+//    via swtch back to the scheduler.
+void scheduler(void)
 {
     struct proc *p;
     struct cpu *c = mycpu();
 
     c->proc = 0;
-
-    int min_average_bursttime = INT_MAX;
-    struct proc *min_average_bursttime_process = 0;
-
-    for (p = proc; p < &proc[NPROC]; p++)
+    c->start = r_time();
+    for (;;)
     {
-        acquire(&p->lock);
-        if (p->state == RUNNABLE)
-        {
-            if (p->performance.average_bursttime < min_average_bursttime)
-            {
-                min_average_bursttime = p->performance.average_bursttime;
-                min_average_bursttime_process = p;
-            }
-            // int Ai_plus1 = ALPHA * p->performance.bursttime - (((100 - ALPHA) * p->performance.average_bursttime) / 100);
-            // if (Ai_plus1 < min_average_bursttime)
-            // {
-            //     min_average_bursttime = Ai_plus1;
-            //     min_average_bursttime_process = p;
-            // }
-        }
-        release(&p->lock);
-    }
+        // Avoid deadlock by ensuring that devices can interrupt.
+        intr_on();
 
-    if (min_average_bursttime_process != 0)
-    {
-        acquire(&min_average_bursttime_process->lock);
-        if (min_average_bursttime_process->state == RUNNABLE)
+        // Look for work with interrupts off, so an interrupt that
+        // makes a process RUNNABLE after the search wakes up the
+        // wfi in cpu_idle() instead of being handled before it.
+        intr_off();
+        p = sched_pick_next();
+        if (p == 0)
         {
-            // Switch to chosen process.  It is the process's job
-            // to release its lock and then reacquire it
-            // before jumping back to us.
-            min_average_bursttime_process->state = RUNNING;
-            c->proc = min_average_bursttime_process;
-
-            min_average_bursttime_process->performance.average_bursttime = min_average_bursttime;
-
-            swtch(&c->context, &min_average_bursttime_process->context);
-
-            // Process is done running for now.
-            // It should have changed its p->state before coming back.
-            c->proc = 0;
+            cpu_idle(c);
+            continue;
         }
-        release(&min_average_bursttime_process->lock);
-    }
-}
-
-void CFSD_policy_scheduler(void)
-{
-    struct proc *p;
-    struct cpu *c = mycpu();
 
-    c->proc = 0;
-
-    int min_runtime_ratio = INT_MAX;
-    struct proc *min_runtime_ratio_process = 0;
-
-    for (p = proc; p < &proc[NPROC]; p++)
-    {
         acquire(&p->lock);
-        if (p->state == RUNNABLE)
+        if (p->state == RUNNABLE && (p->affinity & (1UL << cpuid())) == 0)
         {
-            int runtime_ratio = 0;
-            int partition = p->performance.rutime + p->performance.stime;
-            if (partition != 0)
-            {
-                runtime_ratio = (p->performance.rutime * p->priority) / partition;
-            }
-
-            if (runtime_ratio < min_runtime_ratio)
+            // set_affinity() raced with the pick; send p to a hart it may use.
+            sched_enqueue(p);
+        }
+        else if (p->state == RUNNABLE)
+        {
+            if (cpugroup_park(p))
             {
-                min_runtime_ratio = runtime_ratio;
-                min_runtime_ratio_process = p;
+                // p's group used up its quota after p was queued.
+                release(&p->lock);
+                continue;
             }
-        }
-        release(&p->lock);
-    }
 
-    if (min_runtime_ratio_process != 0)
-    {
-        acquire(&min_runtime_ratio_process->lock);
-        if (min_runtime_ratio_process->state == RUNNABLE)
-        {
             // Switch to chosen process.  It is the process's job
             // to release its lock and then reacquire it
             // before jumping back to us.
-            min_runtime_ratio_process->state = RUNNING;
-            c->proc = min_runtime_ratio_process;
-
-            min_runtime_ratio_process->performance.average_bursttime = min_runtime_ratio;
-
-            swtch(&c->context, &min_runtime_ratio_process->context);
+            if (p->last_cpu >= 0 && p->last_cpu != cpuid())
+            {
+                p->performance.migrations++;
+                sched_trace_event(p, SCHED_EV_MIGRATE, RUNNABLE);
+            }
+            p->last_cpu = cpuid();
+            if (ticks - p->state_tick >= MAX_WAIT)
+                p->performance.starvations++;
+            c->need_resched = 0;
+            set_state(p, RUNNING);
+            uint64 slice = sched_timeslice(p);
+            set_slice_timer(slice != 0 ? p->run_start + slice : 0);
+            c->proc = p;
+            swtch(&c->context, &p->context);
 
             // Process is done running for now.
             // It should have changed its p->state before coming back.
+            set_slice_timer(0);
             c->proc = 0;
         }
-        release(&min_runtime_ratio_process->lock);
-    }
-}
-
-// Per-CPU process scheduler.
-// Each CPU calls scheduler() after setting itself up.
-// Scheduler never returns.  It loops, doing:
-//  - choose a process to run.
-//  - swtch to start running that process.
-//  - eventually that process transfers control
-//    via swtch back to the scheduler.
-void scheduler(void)
-{
-#ifdef FCFS
-    init_FCFS_policy();
-#endif
-    for (;;)
-    {
-        // Avoid deadlock by ensuring that devices can interrupt.
-        intr_on();
-#ifdef DEFAULT
-        default_policy_scheduler();
-#endif
-#ifdef FCFS
-        FCFS_policy_scheduler();
-#endif
-#ifdef SRT
-        SRT_policy_scheduler();
-#endif
-#ifdef CFSD
-        CFSD_policy_scheduler();
-#endif
+        release(&p->lock);
     }
 }
 
@@ -840,13 +745,7 @@ void yield(void)
 {
     struct proc *p = myproc();
     acquire(&p->lock);
-    p->state = RUNNABLE;
-
-    p->performance.bursttime = 0;
-
-#ifdef FCFS
-    enqueue(&queue, p);
-#endif
+    make_runnable(p);
 
     sched();
     release(&p->lock);
@@ -891,7 +790,7 @@ void sleep(void *chan, struct spinlock *lk)
 
     // Go to sleep.
     p->chan = chan;
-    p->state = SLEEPING;
+    set_state(p, SLEEPING);
 
     sched();
 
@@ -916,11 +815,7 @@ void wakeup(void *chan)
             acquire(&p->lock);
             if (p->state == SLEEPING && p->chan == chan)
             {
-                p->state = RUNNABLE;
-
-#ifdef FCFS
-                enqueue(&queue, p);
-#endif
+                make_runnable(p);
             }
             release(&p->lock);
         }
@@ -943,11 +838,7 @@ int kill(int pid)
             if (p->state == SLEEPING)
             {
                 // Wake process from sleep().
-                p->state = RUNNABLE;
-
-#ifdef FCFS
-                enqueue(&queue, p);
-#endif
+                make_runnable(p);
             }
             release(&p->lock);
             return 0;
@@ -1017,6 +908,15 @@ void procdump(void)
         printf("%d %s %s", p->pid, state, p->name);
         printf("\n");
     }
+
+    uint64 now = r_time();
+    for (int i = 0; i < NCPU; i++)
+    {
+        struct cpu *c = &cpus[i];
+        if (c->start == 0 || now == c->start)
+            continue;
+        printf("cpu %d idle %d%%\n", i, (int)(cpu_idle_time(c, now) * 100 / (now - c->start)));
+    }
 }
 
 void set_debug_mode(int flag)
@@ -1109,9 +1009,516 @@ int set_priority(int priority)
     {
         struct proc *p = myproc();
         acquire(&p->lock);
+        // a process that lowers its priority may now owe
+        // the CPU to a queued one, let the scheduler decide.
+        if (priority > p->priority)
+            resched_cpu(cpuid());
         p->priority = priority;
         release(&p->lock);
         return 0;
     }
     return -1;
-}
\ No newline at end of file
+}
+
+// Set the scheduling policy of the process with the given pid,
+// or the system default when pid is SET_POLICY_SYSTEM.
+int set_policy(int policy, int pid)
+{
+    struct proc *p;
+
+    if (pid == SET_POLICY_SYSTEM)
+        return sched_set_default(policy);
+    // set_deadline() is the way into EDF.
+    if (policy < SCHED_SYSTEM || policy >= NSCHED || policy == SCHED_EDF)
+        return -1;
+
+    for (p = proc; p < &proc[NPROC]; p++)
+    {
+        acquire(&p->lock);
+        if (p->pid == pid)
+        {
+            if (p->policy == SCHED_EDF)
+                sched_edf_release(p);
+            p->policy = policy;
+            sched_requeue(p);
+            release(&p->lock);
+            return 0;
+        }
+        release(&p->lock);
+    }
+    return -1;
+}
+
+// Make the current process a periodic EDF process that needs runtime
+// ticks of every period ticks, by deadline ticks into the period.
+// deadline 0 means the end of the period, runtime 0 leaves EDF.
+// Fails if the EDF processes would need more than one CPU.
+int set_deadline(int runtime, int period, int deadline)
+{
+    struct proc *p = myproc();
+
+    if (deadline == 0)
+        deadline = period;
+    if (runtime < 0 || runtime > deadline || deadline > period)
+        return -1;
+
+    acquire(&p->lock);
+    if (runtime == 0)
+    {
+        if (p->policy != SCHED_EDF)
+        {
+            release(&p->lock);
+            return 0;
+        }
+        sched_edf_release(p);
+        p->policy = SCHED_SYSTEM;
+    }
+    else
+    {
+        if (sched_edf_admit(p, runtime, period) < 0)
+        {
+            release(&p->lock);
+            return -1;
+        }
+        p->edf_runtime = runtime;
+        p->edf_period = period;
+        p->edf_deadline = deadline;
+        edf_new_job(p);
+        p->policy = SCHED_EDF;
+    }
+    release(&p->lock);
+
+    // move to the run queue of the new policy now.
+    yield();
+    return 0;
+}
+
+// Copy the time accounting of the first n harts to the
+// struct cpustat array at user address addr.
+// Returns the number of harts copied.
+int cpustat(uint64 addr, int n)
+{
+    struct proc *p = myproc();
+    uint64 now = r_time();
+    struct cpustat st;
+
+    if (n > NCPU)
+        n = NCPU;
+    for (int i = 0; i < n; i++)
+    {
+        struct cpu *c = &cpus[i];
+        st.total = c->start == 0 ? 0 : now - c->start;
+        st.idle = c->start == 0 ? 0 : cpu_idle_time(c, now);
+        if (copyout(p->pagetable, addr + i * sizeof(st), (char *)&st, sizeof(st)) < 0)
+            return -1;
+    }
+    return n < 0 ? 0 : n;
+}
+
+// Find the process with the given pid, or the caller when pid is 0.
+// Returns with p->lock held, or 0 if there is no such process.
+static struct proc *find_proc(int pid)
+{
+    struct proc *p;
+
+    if (pid == 0)
+    {
+        p = myproc();
+        acquire(&p->lock);
+        return p;
+    }
+    for (p = proc; p < &proc[NPROC]; p++)
+    {
+        acquire(&p->lock);
+        if (p->pid == pid && p->state != UNUSED)
+            return p;
+        release(&p->lock);
+    }
+    return 0;
+}
+
+// Let the process with the given pid, or the caller when pid is 0,
+// run only on the harts in mask, bit i for hart i. A RUNNABLE process
+// moves to an allowed hart now, a RUNNING one when it next stops.
+// Fails if mask has none of the harts that are up.
+int set_affinity(int pid, uint64 mask)
+{
+    struct proc *p;
+
+    if ((mask & online_cpus()) == 0)
+        return -1;
+    if ((p = find_proc(pid)) == 0)
+        return -1;
+    p->affinity = mask;
+    sched_requeue(p);
+    int self = p == myproc();
+    release(&p->lock);
+
+    // the caller may be on a hart it has just left.
+    if (self)
+        yield();
+    return 0;
+}
+
+// Set the timeslice of the process with the given pid, or of the
+// caller when pid is 0, to us microseconds, or back to the one its
+// priority and class give it when us is 0. Takes effect the next
+// time the process is dispatched.
+int set_timeslice(int pid, int us)
+{
+    struct proc *p;
+
+    if (us != 0 && (us < MIN_TIMESLICE || us > MAX_TIMESLICE))
+        return -1;
+    if ((p = find_proc(pid)) == 0)
+        return -1;
+    p->timeslice = (uint64)us * TIME_PER_US;
+    release(&p->lock);
+    return 0;
+}
+
+// The timeslice the process with the given pid, or the caller when
+// pid is 0, gets when it is next dispatched, in microseconds, or 0 if
+// its class doesn't limit how long it runs.
+int get_timeslice(int pid)
+{
+    struct proc *p;
+
+    if ((p = find_proc(pid)) == 0)
+        return -1;
+    uint64 slice = sched_timeslice(p);
+    release(&p->lock);
+    return slice / TIME_PER_US;
+}
+
+// Copy the affinity mask of the process with the given pid,
+// or of the caller when pid is 0, to user address addr.
+int get_affinity(int pid, uint64 addr)
+{
+    struct proc *p;
+    uint64 mask;
+
+    if ((p = find_proc(pid)) == 0)
+        return -1;
+    mask = p->affinity & online_cpus();
+    release(&p->lock);
+
+    return copyout(myproc()->pagetable, addr, (char *)&mask, sizeof(mask));
+}
+
+// ------------------- CPU BANDWIDTH GROUPS -------------------
+// A group caps the CPU time its processes get, across all harts, to
+// quota ticks per period. Their running time is charged to the group
+// when a burst ends and on every tick. Once the quota is used up the
+// group is throttled: its running members are preempted and its
+// RUNNABLE members are parked on the group, off the run queues, until
+// cpugroup_refill() starts the next period. A child joins the group
+// of its parent, so a whole process tree shares one quota. A parked
+// process that is killed exits once the next period has begun.
+// Lock order: p->lock, then the group's lock.
+
+struct cpugroup cpugroups[NGROUP];
+int nextgid = 1;
+
+void cpugroupinit(void)
+{
+    for (int i = 0; i < NGROUP; i++)
+        initlock(&cpugroups[i].lock, "cpugroup");
+}
+
+// Find the group with the given id.
+// Returns with its lock held, or 0 if there is no such group.
+static struct cpugroup *find_group(int id)
+{
+    for (struct cpugroup *g = cpugroups; g < &cpugroups[NGROUP]; g++)
+    {
+        acquire(&g->lock);
+        if (g->id == id && id != 0)
+            return g;
+        release(&g->lock);
+    }
+    return 0;
+}
+
+// Charge the CPU time p has run since it was last charged, up to
+// r_time() now, to p's group, and throttle the group if that uses up
+// its quota. p->lock and the group's lock must be held.
+static void group_charge(struct cpugroup *g, struct proc *p, uint64 now)
+{
+    uint64 from = p->group_mark > p->run_start ? p->group_mark : p->run_start;
+
+    if (now > from)
+    {
+        g->runtime += now - from;
+        g->usage += now - from;
+    }
+    p->group_mark = now;
+    if (g->throttled || g->runtime < (uint64)g->quota * TIMER_INTERVAL)
+        return;
+
+    g->throttled = 1;
+    g->throttled_at = ticks;
+    g->nthrottled++;
+    // preempt the members running on other harts (unlocked hint).
+    for (int i = 0; i < NCPU; i++)
+    {
+        struct proc *q = cpus[i].proc;
+        if (q != 0 && q != p && q->group == g)
+            resched_cpu(i);
+    }
+}
+
+// p, RUNNING, has just stopped running at r_time() now.
+// p->lock must be held.
+void cpugroup_charge(struct proc *p, uint64 now)
+{
+    struct cpugroup *g = p->group;
+
+    if (g == 0)
+        return;
+    acquire(&g->lock);
+    group_charge(g, p, now);
+    release(&g->lock);
+}
+
+// Called on every tick for p, the process running on this hart.
+// Returns 1 if p's group has used up its quota, so p must yield.
+int cpugroup_tick(struct proc *p)
+{
+    int throttled = 0;
+
+    acquire(&p->lock);
+    struct cpugroup *g = p->group;
+    if (g != 0)
+    {
+        acquire(&g->lock);
+        group_charge(g, p, r_time());
+        throttled = g->throttled;
+        release(&g->lock);
+    }
+    release(&p->lock);
+    return throttled;
+}
+
+// Park p, RUNNABLE, on its group instead of queueing it, if the
+// group is throttled. Returns 1 if p was parked.
+// p->lock must be held.
+int cpugroup_park(struct proc *p)
+{
+    struct cpugroup *g = p->group;
+
+    if (g == 0)
+        return 0;
+    acquire(&g->lock);
+    if (!g->throttled)
+    {
+        release(&g->lock);
+        return 0;
+    }
+    p->group_next = g->parked;
+    g->parked = p;
+    p->group_parked = 1;
+    release(&g->lock);
+    return 1;
+}
+
+// Take p off its group's parked list. The group's lock must be held.
+static void unpark(struct cpugroup *g, struct proc *p)
+{
+    struct proc **link = &g->parked;
+
+    while (*link != 0 && *link != p)
+        link = &(*link)->group_next;
+    if (*link == p)
+        *link = p->group_next;
+    p->group_next = 0;
+    p->group_parked = 0;
+}
+
+// Start a new period for every group whose period has ended, and
+// queue the processes parked on it. Called by clockintr().
+void cpugroup_refill(void)
+{
+    for (struct cpugroup *g = cpugroups; g < &cpugroups[NGROUP]; g++)
+    {
+        acquire(&g->lock);
+        if (g->id == 0 || ticks - g->period_start < g->period)
+        {
+            release(&g->lock);
+            continue;
+        }
+        g->period_start = ticks;
+        g->periods++;
+        g->runtime = 0;
+        if (g->throttled)
+        {
+            g->throttled = 0;
+            g->throttled_time += ticks - g->throttled_at;
+        }
+        release(&g->lock);
+
+        // parked processes are RUNNABLE and on no run queue, so
+        // nothing else queues them; but they may move to another
+        // group meanwhile, see cpugroup_join().
+        for (;;)
+        {
+            acquire(&g->lock);
+            struct proc *p = g->throttled ? 0 : g->parked;
+            if (p != 0)
+                unpark(g, p);
+            release(&g->lock);
+            if (p == 0)
+                break;
+
+            acquire(&p->lock);
+            if (!cpugroup_park(p))
+                sched_enqueue(p);
+            release(&p->lock);
+        }
+    }
+}
+
+// Take p out of its group, when it exits or moves to another one,
+// freeing the group if p was its last process. Returns 1 if p was
+// parked on the group, so the caller must queue it; 0 if it was not,
+// or cpugroup_refill() has unparked it and will queue it.
+// p->lock must be held.
+int cpugroup_leave(struct proc *p)
+{
+    struct cpugroup *g = p->group;
+    int parked;
+
+    if (g == 0)
+        return 0;
+    acquire(&g->lock);
+    parked = p->group_parked;
+    if (parked)
+        unpark(g, p);
+    if (--g->nprocs == 0)
+    {
+        g->id = 0;
+        g->parked = 0;
+    }
+    release(&g->lock);
+    p->group = 0;
+    return parked;
+}
+
+// Put np, a new child of p, in p's group.
+// p->lock and np->lock must be held.
+void cpugroup_fork(struct proc *p, struct proc *np)
+{
+    struct cpugroup *g = p->group;
+
+    np->group = g;
+    np->group_mark = 0;
+    if (g == 0)
+        return;
+    acquire(&g->lock);
+    g->nprocs++;
+    release(&g->lock);
+}
+
+// Move the process with the given pid, or the caller when pid is 0,
+// to the group with id gid, or out of its group when gid is 0.
+// The time it has run so far stays charged to its old group.
+int cpugroup_join(int pid, int gid)
+{
+    struct proc *p;
+    struct cpugroup *g = 0;
+
+    if ((p = find_proc(pid)) == 0)
+        return -1;
+    // a process being set up or exiting would never leave the group.
+    if (p->state != RUNNABLE && p->state != RUNNING && p->state != SLEEPING)
+    {
+        release(&p->lock);
+        return -1;
+    }
+    if (gid != 0)
+    {
+        if ((g = find_group(gid)) == 0)
+        {
+            release(&p->lock);
+            return -1;
+        }
+        g->nprocs++;
+        release(&g->lock);
+    }
+
+    if (p->state == RUNNING)
+        cpugroup_charge(p, r_time());
+    int parked = cpugroup_leave(p);
+    p->group = g;
+    if (parked && !cpugroup_park(p))
+        sched_enqueue(p);
+    release(&p->lock);
+    return 0;
+}
+
+// Create a group that may use quota ticks of CPU time per period
+// ticks, and move the caller into it. quota may exceed period, up to
+// the number of harts times period, for a group that runs on several
+// harts at once. Returns the id of the group, or -1.
+int cpugroup_create(int quota, int period)
+{
+    struct cpugroup *g;
+
+    if (quota < 1 || period < 1 || quota > period * NCPU)
+        return -1;
+    for (g = cpugroups; g < &cpugroups[NGROUP]; g++)
+    {
+        acquire(&g->lock);
+        if (g->id == 0)
+            break;
+        release(&g->lock);
+    }
+    if (g == &cpugroups[NGROUP])
+        return -1;
+
+    g->id = __sync_fetch_and_add(&nextgid, 1);
+    g->quota = quota;
+    g->period = period;
+    g->period_start = ticks;
+    g->runtime = 0;
+    g->throttled = 0;
+    g->parked = 0;
+    g->usage = 0;
+    g->periods = 0;
+    g->nthrottled = 0;
+    g->throttled_time = 0;
+    int id = g->id;
+    // count the caller already, who joins next,
+    // so nothing frees the group meanwhile.
+    g->nprocs = 1;
+    release(&g->lock);
+
+    struct proc *p = myproc();
+    acquire(&p->lock);
+    cpugroup_charge(p, r_time());
+    cpugroup_leave(p);
+    p->group = g;
+    release(&p->lock);
+    return id;
+}
+
+// Copy the counters of the group with id gid to user address addr.
+int cpugroup_stat(int gid, uint64 addr)
+{
+    struct cpugroup *g;
+    struct cpugroup_stat st;
+
+    if ((g = find_group(gid)) == 0)
+        return -1;
+    st.quota = g->quota;
+    st.period = g->period;
+    st.nprocs = g->nprocs;
+    st.throttled = g->throttled;
+    st.usage = g->usage;
+    st.periods = g->periods;
+    st.nthrottled = g->nthrottled;
+    st.throttled_time = g->throttled_time + (g->throttled ? ticks - g->throttled_at : 0);
+    release(&g->lock);
+
+    return copyout(myproc()->pagetable, addr, (char *)&st, sizeof(st));
+}
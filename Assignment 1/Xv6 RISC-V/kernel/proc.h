@@ -1,3 +1,5 @@
+#include "sched.h"
+
 // Saved registers for kernel context switches.
 struct context
 {
@@ -26,6 +28,10 @@ struct cpu
     struct context context; // swtch() here to enter scheduler().
     int noff;               // Depth of push_off() nesting.
     int intena;             // Were interrupts enabled before push_off()?
+    uint64 start;           // r_time() when this cpu entered scheduler()
+    uint64 idle;            // r_time() units spent waiting in wfi
+    uint64 idle_start;      // r_time() when the current wait began, or 0
+    int need_resched;       // call the scheduler at the next trap return
 };
 
 extern struct cpu cpus[NCPU];
@@ -93,16 +99,8 @@ enum procstate
     ZOMBIE
 };
 
-struct perf
-{
-    int ctime;             // process creation time
-    int ttime;             // process termination time
-    int stime;             // the total time the process spent in the SLEEPING state
-    int retime;            // the total time the process spent in the RUNNABLE state
-    int rutime;            // the total time the process spent in the RUNNING state
-    int bursttime;         // process burst time
-    int average_bursttime; // approximate estimated burst time
-};
+struct sched_class;
+struct cpugroup;
 
 // Per-process state
 struct proc
@@ -111,6 +109,7 @@ struct proc
 
     // p->lock must be held when using these:
     enum procstate state; // Process state
+    uint state_tick;      // ticks at the last change of state
     void *chan;           // If non-zero, sleeping on chan
     int killed;           // If non-zero, have been killed
     int xstate;           // Exit status to be returned to parent's wait
@@ -119,6 +118,37 @@ struct proc
     int mask;                // Process traced mask
     struct perf performance; // Process perfomance
     int priority;            // Process priority
+    uint64 vruntime;         // Weighted virtual runtime in r_time() units, used by CFSD
+    uint64 run_start;        // r_time() when p last started RUNNING
+    uint64 burst_avg;        // Estimated CPU burst in r_time() units, times 100
+    uint64 timeslice;        // Timeslice set by sched_settimeslice() in r_time() units, or 0
+    struct rb_node rb_node;  // CFSD run queue node, keyed by vruntime
+    int policy;              // Scheduling policy, or SCHED_SYSTEM
+    int mlfq_level;          // MLFQ level, 0 is the highest
+    uint mlfq_epoch;         // MLFQ boost period p was last queued in
+    uint64 mlfq_used;        // r_time() units of the MLFQ level's timeslice used up
+    uint64 pass;             // Stride scheduling pass value
+    int edf_runtime;         // EDF runtime budget per period, in ticks
+    int edf_period;          // EDF period, in ticks
+    int edf_deadline;        // EDF deadline, relative to the start of a period
+    uint64 edf_bw;           // EDF bandwidth reserved by admission control
+    uint edf_abs_deadline;   // deadline of the current EDF job
+    uint edf_period_end;     // start of the next EDF period
+    int edf_budget;          // runtime left in the current EDF period
+    int edf_missed;          // current EDF job has missed its deadline
+    uint64 affinity;         // Harts p may run on, bit i for hart i
+    int last_cpu;            // Hart p last ran on, or -1
+    struct cpugroup *group;  // CPU bandwidth group, or 0
+    uint64 group_mark;       // r_time() up to which p's running time is charged to group
+
+    // the lock of p's group protects these:
+    struct proc *group_next; // next process parked on the group
+    int group_parked;        // p is RUNNABLE but parked until the group's next period
+
+    // the lock of the run queue that holds p protects these:
+    struct sched_class *sched_class; // Class of the run queue p was last put on
+    int rq_cpu;                      // CPU whose run queue holds p, or -1
+    int rq_weight;                   // Load weight p added to that run queue
 
     // proc_tree_lock must be held when using this:
     struct proc *parent; // Parent process
@@ -133,3 +163,25 @@ struct proc
     struct inode *cwd;           // Current directory
     char name[16];               // Process name (debugging)
 };
+
+// A CPU bandwidth group: its processes may use quota ticks of CPU
+// time, on all harts together, in every period ticks.
+struct cpugroup
+{
+    struct spinlock lock;
+    int id;              // 0 if the slot is free
+    int nprocs;          // processes in the group
+    int quota;           // ticks of CPU time per period
+    int period;          // ticks
+    uint period_start;   // ticks when the current period began
+    uint64 runtime;      // CPU time used in the current period, in r_time() units
+    int throttled;       // quota used up, members wait for the next period
+    uint throttled_at;   // ticks when the group was throttled
+    struct proc *parked; // RUNNABLE members kept off the run queues while throttled
+
+    // counters, for cpugroup_stat().
+    uint64 usage;          // CPU time used, in r_time() units
+    uint64 periods;        // periods that have ended
+    uint64 nthrottled;     // periods in which the quota ran out
+    uint64 throttled_time; // ticks spent throttled
+};
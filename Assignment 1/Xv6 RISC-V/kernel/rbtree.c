@@ -0,0 +1,294 @@
+// Red-black tree, as described in CLRS chapter 13.
+// Callers provide the locking.
+
+#include "types.h"
+#include "rbtree.h"
+
+static void rotate_left(struct rb_root *root, struct rb_node *x)
+{
+    struct rb_node *y = x->right;
+
+    x->right = y->left;
+    if (y->left)
+        y->left->parent = x;
+    y->parent = x->parent;
+    if (x->parent == 0)
+        root->root = y;
+    else if (x == x->parent->left)
+        x->parent->left = y;
+    else
+        x->parent->right = y;
+    y->left = x;
+    x->parent = y;
+}
+
+static void rotate_right(struct rb_root *root, struct rb_node *x)
+{
+    struct rb_node *y = x->left;
+
+    x->left = y->right;
+    if (y->right)
+        y->right->parent = x;
+    y->parent = x->parent;
+    if (x->parent == 0)
+        root->root = y;
+    else if (x == x->parent->right)
+        x->parent->right = y;
+    else
+        x->parent->left = y;
+    y->right = x;
+    x->parent = y;
+}
+
+static int is_black(struct rb_node *node)
+{
+    return node == 0 || node->color == RB_BLACK;
+}
+
+void rb_init(struct rb_root *root)
+{
+    root->root = 0;
+    root->leftmost = 0;
+}
+
+// Return the node with the smallest key, or 0 if the tree is empty.
+struct rb_node *
+rb_first(struct rb_root *root)
+{
+    return root->leftmost;
+}
+
+// Return the in-order successor of node, or 0 if it is the last one.
+struct rb_node *
+rb_next(struct rb_node *node)
+{
+    if (node->right)
+    {
+        node = node->right;
+        while (node->left)
+            node = node->left;
+        return node;
+    }
+    while (node->parent && node == node->parent->right)
+        node = node->parent;
+    return node->parent;
+}
+
+void rb_insert(struct rb_root *root, struct rb_node *node)
+{
+    struct rb_node **link = &root->root;
+    struct rb_node *parent = 0;
+    int leftmost = 1;
+
+    while (*link)
+    {
+        parent = *link;
+        if (node->key < parent->key)
+        {
+            link = &parent->left;
+        }
+        else
+        {
+            link = &parent->right;
+            leftmost = 0;
+        }
+    }
+
+    node->parent = parent;
+    node->left = 0;
+    node->right = 0;
+    node->color = RB_RED;
+    *link = node;
+    if (leftmost)
+        root->leftmost = node;
+
+    // restore the red-black properties.
+    while (node->parent && node->parent->color == RB_RED)
+    {
+        // a red parent is never the root, so the grandparent exists.
+        struct rb_node *gparent = node->parent->parent;
+        if (node->parent == gparent->left)
+        {
+            struct rb_node *uncle = gparent->right;
+            if (!is_black(uncle))
+            {
+                node->parent->color = RB_BLACK;
+                uncle->color = RB_BLACK;
+                gparent->color = RB_RED;
+                node = gparent;
+            }
+            else
+            {
+                if (node == node->parent->right)
+                {
+                    node = node->parent;
+                    rotate_left(root, node);
+                }
+                node->parent->color = RB_BLACK;
+                gparent->color = RB_RED;
+                rotate_right(root, gparent);
+            }
+        }
+        else
+        {
+            struct rb_node *uncle = gparent->left;
+            if (!is_black(uncle))
+            {
+                node->parent->color = RB_BLACK;
+                uncle->color = RB_BLACK;
+                gparent->color = RB_RED;
+                node = gparent;
+            }
+            else
+            {
+                if (node == node->parent->left)
+                {
+                    node = node->parent;
+                    rotate_right(root, node);
+                }
+                node->parent->color = RB_BLACK;
+                gparent->color = RB_RED;
+                rotate_left(root, gparent);
+            }
+        }
+    }
+    root->root->color = RB_BLACK;
+}
+
+// Replace the subtree rooted at u with the subtree rooted at v.
+static void transplant(struct rb_root *root, struct rb_node *u, struct rb_node *v)
+{
+    if (u->parent == 0)
+        root->root = v;
+    else if (u == u->parent->left)
+        u->parent->left = v;
+    else
+        u->parent->right = v;
+    if (v)
+        v->parent = u->parent;
+}
+
+// Fix a missing black on the path through x, whose parent is parent.
+// x may be null, which is why the parent is passed separately.
+static void erase_fixup(struct rb_root *root, struct rb_node *x, struct rb_node *parent)
+{
+    while (x != root->root && is_black(x))
+    {
+        if (x == parent->left)
+        {
+            struct rb_node *sibling = parent->right;
+            if (!is_black(sibling))
+            {
+                sibling->color = RB_BLACK;
+                parent->color = RB_RED;
+                rotate_left(root, parent);
+                sibling = parent->right;
+            }
+            if (is_black(sibling->left) && is_black(sibling->right))
+            {
+                sibling->color = RB_RED;
+                x = parent;
+                parent = x->parent;
+            }
+            else
+            {
+                if (is_black(sibling->right))
+                {
+                    sibling->left->color = RB_BLACK;
+                    sibling->color = RB_RED;
+                    rotate_right(root, sibling);
+                    sibling = parent->right;
+                }
+                sibling->color = parent->color;
+                parent->color = RB_BLACK;
+                sibling->right->color = RB_BLACK;
+                rotate_left(root, parent);
+                x = root->root;
+            }
+        }
+        else
+        {
+            struct rb_node *sibling = parent->left;
+            if (!is_black(sibling))
+            {
+                sibling->color = RB_BLACK;
+                parent->color = RB_RED;
+                rotate_right(root, parent);
+                sibling = parent->left;
+            }
+            if (is_black(sibling->left) && is_black(sibling->right))
+            {
+                sibling->color = RB_RED;
+                x = parent;
+                parent = x->parent;
+            }
+            else
+            {
+                if (is_black(sibling->left))
+                {
+                    sibling->right->color = RB_BLACK;
+                    sibling->color = RB_RED;
+                    rotate_left(root, sibling);
+                    sibling = parent->left;
+                }
+                sibling->color = parent->color;
+                parent->color = RB_BLACK;
+                sibling->left->color = RB_BLACK;
+                rotate_right(root, parent);
+                x = root->root;
+            }
+        }
+    }
+    if (x)
+        x->color = RB_BLACK;
+}
+
+void rb_erase(struct rb_root *root, struct rb_node *node)
+{
+    struct rb_node *x, *parent;
+    int color = node->color;
+
+    if (root->leftmost == node)
+        root->leftmost = rb_next(node);
+
+    if (node->left == 0)
+    {
+        x = node->right;
+        parent = node->parent;
+        transplant(root, node, node->right);
+    }
+    else if (node->right == 0)
+    {
+        x = node->left;
+        parent = node->parent;
+        transplant(root, node, node->left);
+    }
+    else
+    {
+        // replace node with its successor, the leftmost node
+        // of its right subtree, which has no left child.
+        struct rb_node *next = node->right;
+        while (next->left)
+            next = next->left;
+        color = next->color;
+        x = next->right;
+        if (next->parent == node)
+        {
+            parent = next;
+        }
+        else
+        {
+            parent = next->parent;
+            transplant(root, next, next->right);
+            next->right = node->right;
+            next->right->parent = next;
+        }
+        transplant(root, node, next);
+        next->left = node->left;
+        next->left->parent = next;
+        next->color = node->color;
+    }
+
+    if (color == RB_BLACK)
+        erase_fixup(root, x, parent);
+}
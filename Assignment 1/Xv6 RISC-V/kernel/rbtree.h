@@ -0,0 +1,24 @@
+// Intrusive red-black tree, ordered by an integer key.
+// The tree caches its leftmost node, so the smallest key
+// is found in O(1) and inserts and erases cost O(log n).
+struct rb_node
+{
+    struct rb_node *parent;
+    struct rb_node *left;
+    struct rb_node *right;
+    int color;  // RB_RED or RB_BLACK
+    uint64 key; // Nodes with equal keys keep insertion order
+};
+
+struct rb_root
+{
+    struct rb_node *root;
+    struct rb_node *leftmost; // Node with the smallest key, or null
+};
+
+#define RB_RED 0
+#define RB_BLACK 1
+
+// get the struct that embeds the rb_node pointed by ptr.
+#define rb_entry(ptr, type, member) \
+    ((type *)((char *)(ptr) - (uint64) & ((type *)0)->member))
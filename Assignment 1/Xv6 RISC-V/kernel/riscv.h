@@ -279,6 +279,14 @@ intr_get()
   return (x & SSTATUS_SIE) != 0;
 }
 
+// wait for an interrupt. returns right away if one is
+// already pending, even with device interrupts off.
+static inline void
+wfi()
+{
+  asm volatile("wfi");
+}
+
 static inline uint64
 r_sp()
 {
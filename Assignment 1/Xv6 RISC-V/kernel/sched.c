@@ -0,0 +1,1188 @@
+// Scheduling classes.
+//
+// Each policy in sched.h is a sched_class with its own queue in every
+// CPU's runqueue. make_runnable() puts a process on the run queue of
+// the CPU that made it runnable, under the class of its policy, and
+// scheduler() asks the classes in pick_order for the next process.
+// A CPU with nothing queued steals from the busiest peer, and
+// sched_balance() evens out the run queues of busy CPUs.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "rbtree.h"
+#include "proc.h"
+#include "sched.h"
+#include "defs.h"
+
+// ------------------- QUEUE -------------------
+// A structure to represent a queue
+struct Queue
+{
+    int front, rear, size;
+    unsigned capacity;
+    struct proc *array[NPROC];
+};
+
+// function to create a queue
+// It initializes size of queue as 0
+void initQueue(struct Queue *queue)
+{
+    queue->capacity = NPROC;
+    queue->front = 0;
+    queue->size = 0;
+    queue->rear = queue->capacity - 1;
+    for (int i = 0; i < queue->capacity; i++) // clear array
+    {
+        queue->array[i] = 0;
+    }
+}
+
+// Queue is full when size becomes
+// equal to the capacity
+int isFull(struct Queue *queue)
+{
+    return (queue->size == queue->capacity);
+}
+
+// Queue is empty when size is 0
+int isEmpty(struct Queue *queue)
+{
+    return (queue->size == 0);
+}
+
+// Function to add an item to the queue.
+// It changes rear and size
+void enqueue(struct Queue *queue, struct proc *item)
+{
+    if (isFull(queue))
+        return;
+    queue->rear = (queue->rear + 1) % queue->capacity;
+    queue->array[queue->rear] = item;
+    queue->size = queue->size + 1;
+}
+
+// Function to remove an item from queue.
+// It changes front and size
+struct proc *dequeue(struct Queue *queue)
+{
+    if (isEmpty(queue))
+        return 0;
+    struct proc *item = queue->array[queue->front];
+    queue->front = (queue->front + 1) % queue->capacity;
+    queue->size = queue->size - 1;
+
+    return item;
+}
+
+// Function to remove a given item, keeping the order of the rest.
+// It changes rear and size
+void removeFromQueue(struct Queue *queue, struct proc *item)
+{
+    int i, n;
+
+    for (n = 0; n < queue->size; n++)
+        if (queue->array[(queue->front + n) % queue->capacity] == item)
+            break;
+    if (n == queue->size)
+        return;
+    for (; n < queue->size - 1; n++)
+    {
+        i = (queue->front + n) % queue->capacity;
+        queue->array[i] = queue->array[(i + 1) % queue->capacity];
+    }
+    queue->rear = (queue->rear + queue->capacity - 1) % queue->capacity;
+    queue->size = queue->size - 1;
+}
+// ------------------- END OF QUEUE -------------------
+
+// ------------------- HEAP -------------------
+// A binary min-heap of processes.
+// Each node keeps the key the process had when it was inserted,
+// so later updates of the key's source can't break the heap order.
+struct HeapNode
+{
+    uint64 key;
+    struct proc *proc;
+};
+
+struct Heap
+{
+    int size;
+    struct HeapNode array[NPROC];
+};
+
+void initHeap(struct Heap *heap)
+{
+    heap->size = 0;
+}
+
+// Move the node at index i up until its parent has a smaller key.
+static void siftUp(struct Heap *heap, int i)
+{
+    struct HeapNode node = heap->array[i];
+    while (i > 0 && heap->array[(i - 1) / 2].key > node.key)
+    {
+        heap->array[i] = heap->array[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap->array[i] = node;
+}
+
+// Move the node at index i down until its children have larger keys.
+static void siftDown(struct Heap *heap, int i)
+{
+    struct HeapNode node = heap->array[i];
+    for (;;)
+    {
+        int child = 2 * i + 1;
+        if (child >= heap->size)
+            break;
+        if (child + 1 < heap->size && heap->array[child + 1].key < heap->array[child].key)
+            child++;
+        if (node.key <= heap->array[child].key)
+            break;
+        heap->array[i] = heap->array[child];
+        i = child;
+    }
+    heap->array[i] = node;
+}
+
+// Function to add an item to the heap.
+void heapPush(struct Heap *heap, struct proc *item, uint64 key)
+{
+    if (heap->size == NPROC)
+        return;
+    int i = heap->size++;
+    heap->array[i].key = key;
+    heap->array[i].proc = item;
+    siftUp(heap, i);
+}
+
+// Function to remove the item at index i.
+// Moves the last node into its place and restores the order.
+static void heapRemoveAt(struct Heap *heap, int i)
+{
+    heap->array[i] = heap->array[--heap->size];
+    if (i < heap->size)
+    {
+        siftUp(heap, i);
+        siftDown(heap, i);
+    }
+}
+
+// Function to remove the item with the smallest key.
+struct proc *heapPop(struct Heap *heap)
+{
+    if (heap->size == 0)
+        return 0;
+    struct proc *item = heap->array[0].proc;
+    heapRemoveAt(heap, 0);
+
+    return item;
+}
+
+// Function to restore the order after keys were changed in place.
+void heapify(struct Heap *heap)
+{
+    for (int i = heap->size / 2 - 1; i >= 0; i--)
+        siftDown(heap, i);
+}
+
+// Function to remove a given item.
+void heapRemove(struct Heap *heap, struct proc *item)
+{
+    for (int i = 0; i < heap->size; i++)
+    {
+        if (heap->array[i].proc == item)
+        {
+            heapRemoveAt(heap, i);
+            return;
+        }
+    }
+}
+// ------------------- END OF HEAP -------------------
+
+// ------------------- CFS RUN QUEUE -------------------
+// A red-black tree of processes keyed by vruntime.
+// A process's vruntime only grows while it is RUNNING, so the
+// key of a queued process only changes when sched_age() moves it.
+struct CFSRunQueue
+{
+    struct rb_root tree;
+    uint64 min_vruntime; // vruntime of the last process picked here
+};
+
+void initCFSRunQueue(struct CFSRunQueue *cfs)
+{
+    rb_init(&cfs->tree);
+    cfs->min_vruntime = 0;
+}
+// ------------------- END OF CFS RUN QUEUE -------------------
+
+// Per-CPU run queue, with a queue for every scheduling class.
+// One lock covers all of them, so an enqueue or a pick costs
+// a single lock round trip. Lock order: p->lock, then rq->lock.
+struct runqueue
+{
+    struct spinlock lock;
+    int cpu;                        // index of this run queue in runqueues[]
+    int nr_running[NSCHED];         // number of queued processes of each class
+    int load;                       // sum of the load weights of queued processes
+    struct Queue rr;                // SCHED_DEFAULT
+    struct Queue fcfs;              // SCHED_FCFS
+    struct Heap srt;                // SCHED_SRT
+    struct CFSRunQueue cfs;         // SCHED_CFSD
+    struct Queue mlfq[MLFQ_LEVELS]; // SCHED_MLFQ, one queue per level
+    uint mlfq_epoch;                // boost period of the MLFQ levels
+    struct Heap stride;             // SCHED_STRIDE, keyed by pass
+    uint64 stride_pass;             // pass of the last process picked here
+    struct Heap edf;                // SCHED_EDF, keyed by absolute deadline
+    struct Queue edf_throttled;     // SCHED_EDF, budget used up for this period
+};
+
+struct runqueue runqueues[NCPU];
+
+// A scheduling class. rq->lock must be held when calling
+// enqueue, dequeue and pick_next.
+struct sched_class
+{
+    char *name;
+    int policy;
+    // add p, which has just become RUNNABLE.
+    void (*enqueue)(struct runqueue *rq, struct proc *p);
+    // remove p, which is queued on rq.
+    void (*dequeue)(struct runqueue *rq, struct proc *p);
+    // remove and return the process to run next on cpu, or 0.
+    // when cpu is not rq->cpu, only take a process that may run there.
+    struct proc *(*pick_next)(struct runqueue *rq, int cpu);
+    // called on each timer interrupt while p is RUNNING.
+    // returns 1 if p should give up the CPU.
+    int (*tick)(struct proc *p);
+    // returns 1 if p, just queued, should preempt curr, which runs
+    // under the same class. null if the class never preempts.
+    int (*preempt)(struct proc *p, struct proc *curr);
+};
+
+// May p run on cpu? Processes queued on a run queue may run on
+// its CPU, so only thieves and the load balancer need to ask.
+static int runs_on(struct proc *p, int cpu)
+{
+    return (p->affinity >> cpu) & 1;
+}
+
+// Remove the oldest, or with newest set the newest, process in
+// queue that may run on cpu.
+static struct proc *steal_from_queue(struct Queue *queue, int cpu, int newest)
+{
+    for (int n = 0; n < queue->size; n++)
+    {
+        int i = newest ? queue->rear - n : queue->front + n;
+        struct proc *p = queue->array[(i + queue->capacity) % queue->capacity];
+        if (runs_on(p, cpu))
+        {
+            removeFromQueue(queue, p);
+            return p;
+        }
+    }
+    return 0;
+}
+
+// Remove the process with the smallest key in heap
+// that may run on cpu.
+static struct proc *steal_from_heap(struct Heap *heap, int cpu)
+{
+    int best = -1;
+
+    for (int i = 0; i < heap->size; i++)
+        if (runs_on(heap->array[i].proc, cpu) && (best < 0 || heap->array[i].key < heap->array[best].key))
+            best = i;
+    if (best < 0)
+        return 0;
+    struct proc *p = heap->array[best].proc;
+    heapRemoveAt(heap, best);
+    return p;
+}
+
+// The timeslice of p: the one sched_settimeslice() gave it, else
+// QUANTUM ticks scaled by its priority, so high priority, latency
+// sensitive processes get short timeslices and low priority ones,
+// throughput jobs, long timeslices. In r_time() units.
+static uint64 base_timeslice(struct proc *p)
+{
+    if (p->timeslice != 0)
+        return p->timeslice;
+    return (uint64)QUANTUM * TIMER_INTERVAL * p->priority / Normal_Priority;
+}
+
+// The timer ends the timeslice, see sched_timeslice(),
+// so a tick needs no preemption check.
+static int slice_tick(struct proc *p)
+{
+    return 0;
+}
+
+// ------------------- DEFAULT -------------------
+// Round robin over a FIFO queue.
+static void default_enqueue(struct runqueue *rq, struct proc *p)
+{
+    enqueue(&rq->rr, p);
+}
+
+static void default_dequeue(struct runqueue *rq, struct proc *p)
+{
+    removeFromQueue(&rq->rr, p);
+}
+
+static struct proc *default_pick_next(struct runqueue *rq, int cpu)
+{
+    if (cpu != rq->cpu)
+        return steal_from_queue(&rq->rr, cpu, 0);
+    return dequeue(&rq->rr);
+}
+
+// ------------------- FCFS -------------------
+// Runs processes in arrival order and never preempts them.
+static void FCFS_enqueue(struct runqueue *rq, struct proc *p)
+{
+    enqueue(&rq->fcfs, p);
+}
+
+static void FCFS_dequeue(struct runqueue *rq, struct proc *p)
+{
+    removeFromQueue(&rq->fcfs, p);
+}
+
+// The owner takes the oldest arrival, a thief the newest one.
+static struct proc *FCFS_pick_next(struct runqueue *rq, int cpu)
+{
+    if (cpu != rq->cpu)
+        return steal_from_queue(&rq->fcfs, cpu, 1);
+    return dequeue(&rq->fcfs);
+}
+
+static int FCFS_tick(struct proc *p)
+{
+    return 0;
+}
+
+// ------------------- SRT -------------------
+// Runs the process with the smallest estimated CPU burst first.
+static void SRT_enqueue(struct runqueue *rq, struct proc *p)
+{
+    heapPush(&rq->srt, p, p->burst_avg);
+}
+
+static void SRT_dequeue(struct runqueue *rq, struct proc *p)
+{
+    heapRemove(&rq->srt, p);
+}
+
+static struct proc *SRT_pick_next(struct runqueue *rq, int cpu)
+{
+    if (cpu != rq->cpu)
+        return steal_from_heap(&rq->srt, cpu);
+    return heapPop(&rq->srt);
+}
+
+static int SRT_preempt(struct proc *p, struct proc *curr)
+{
+    return p->burst_avg < curr->burst_avg;
+}
+
+// ------------------- CFSD -------------------
+// Runs the process with the smallest weighted vruntime first.
+
+// A process that slept or is new starts at min_vruntime,
+// so it can't monopolize the CPU.
+static void CFSD_enqueue(struct runqueue *rq, struct proc *p)
+{
+    if (p->vruntime < rq->cfs.min_vruntime)
+        p->vruntime = rq->cfs.min_vruntime;
+    p->rb_node.key = p->vruntime;
+    rb_insert(&rq->cfs.tree, &p->rb_node);
+}
+
+static void CFSD_dequeue(struct runqueue *rq, struct proc *p)
+{
+    rb_erase(&rq->cfs.tree, &p->rb_node);
+}
+
+// Take the process with the smallest vruntime, the leftmost node.
+// A thief takes the leftmost process that may run on its CPU.
+static struct proc *CFSD_pick_next(struct runqueue *rq, int cpu)
+{
+    struct rb_node *node = rb_first(&rq->cfs.tree);
+    while (cpu != rq->cpu && node != 0 && !runs_on(rb_entry(node, struct proc, rb_node), cpu))
+        node = rb_next(node);
+    if (node == 0)
+        return 0;
+    rb_erase(&rq->cfs.tree, node);
+    if (node->key > rq->cfs.min_vruntime)
+        rq->cfs.min_vruntime = node->key;
+
+    return rb_entry(node, struct proc, rb_node);
+}
+
+// curr's vruntime only grows when its burst ends, so estimate it
+// from the ticks curr has been running. p must be ahead by more than
+// a tick, so two processes don't keep preempting each other.
+static int CFSD_preempt(struct proc *p, struct proc *curr)
+{
+    uint64 vruntime = curr->vruntime + (uint64)(ticks - curr->state_tick) * TIMER_INTERVAL * curr->priority;
+    return p->vruntime + TIMER_INTERVAL < vruntime;
+}
+
+// ------------------- MLFQ -------------------
+// Runs the highest non-empty level in round robin. A process that
+// uses up the timeslice of its level, its timeslice << level, moves
+// one level down, so CPU bound work sinks to long timeslices while
+// processes that mostly sleep stay on top. Every MLFQ_BOOST ticks
+// all processes return to level 0, so nothing starves down there.
+
+// The boost period is derived from ticks, so the boost needs
+// no timer hook: processes and queues that belong to an older
+// period are moved to level 0 the next time they are touched.
+static uint mlfq_current_epoch(void)
+{
+    return ticks / MLFQ_BOOST;
+}
+
+static void MLFQ_enqueue(struct runqueue *rq, struct proc *p)
+{
+    uint epoch = mlfq_current_epoch();
+
+    if (p->mlfq_epoch != epoch)
+    {
+        p->mlfq_epoch = epoch;
+        p->mlfq_level = 0;
+        p->mlfq_used = 0;
+    }
+    enqueue(&rq->mlfq[p->mlfq_level], p);
+}
+
+static void MLFQ_dequeue(struct runqueue *rq, struct proc *p)
+{
+    for (int level = 0; level < MLFQ_LEVELS; level++)
+        removeFromQueue(&rq->mlfq[level], p);
+}
+
+static struct proc *MLFQ_pick_next(struct runqueue *rq, int cpu)
+{
+    uint epoch = mlfq_current_epoch();
+    struct proc *p;
+
+    // boost: move every queued process to level 0, keeping their order.
+    if (rq->mlfq_epoch != epoch)
+    {
+        for (int level = 1; level < MLFQ_LEVELS; level++)
+            while ((p = dequeue(&rq->mlfq[level])) != 0)
+                enqueue(&rq->mlfq[0], p);
+        rq->mlfq_epoch = epoch;
+    }
+
+    for (int level = 0; level < MLFQ_LEVELS; level++)
+    {
+        p = cpu != rq->cpu ? steal_from_queue(&rq->mlfq[level], cpu, 0) : dequeue(&rq->mlfq[level]);
+        if (p != 0)
+        {
+            if (p->mlfq_epoch != epoch)
+            {
+                p->mlfq_epoch = epoch;
+                p->mlfq_used = 0;
+            }
+            p->mlfq_level = level;
+            return p;
+        }
+    }
+    return 0;
+}
+
+static int MLFQ_preempt(struct proc *p, struct proc *curr)
+{
+    return p->mlfq_level < curr->mlfq_level;
+}
+
+// Charge a CPU burst of p to the timeslice of its level. The used
+// part is not reset when the process sleeps, so a process can't keep
+// its level by sleeping just before the timeslice ends.
+static void mlfq_charge(struct proc *p, uint64 burst)
+{
+    p->mlfq_used += burst;
+    if (p->mlfq_used >= base_timeslice(p) << p->mlfq_level)
+    {
+        if (p->mlfq_level < MLFQ_LEVELS - 1)
+            p->mlfq_level++;
+        p->mlfq_used = 0;
+    }
+}
+
+static int MLFQ_tick(struct proc *p)
+{
+    struct runqueue *rq = &runqueues[cpuid()];
+
+    // let a process waiting on a higher level run (unlocked hint).
+    for (int level = 0; level < p->mlfq_level; level++)
+        if (!isEmpty(&rq->mlfq[level]))
+            return 1;
+    return 0;
+}
+
+// ------------------- STRIDE -------------------
+// Proportional share: a process gets CPU time in proportion to its
+// tickets, STRIDE_TICKETS(priority). Each process advances its pass
+// by its stride, STRIDE1 / tickets, for every tick it runs, and the
+// process with the smallest pass runs next.
+
+#define STRIDE1 (1 << 20) // divided by the tickets to get the stride
+
+// A process that slept or is new starts at the pass of the last
+// process picked, so it can't use the time it didn't run.
+static void STRIDE_enqueue(struct runqueue *rq, struct proc *p)
+{
+    if (p->pass < rq->stride_pass)
+        p->pass = rq->stride_pass;
+    heapPush(&rq->stride, p, p->pass);
+}
+
+static void STRIDE_dequeue(struct runqueue *rq, struct proc *p)
+{
+    heapRemove(&rq->stride, p);
+}
+
+static struct proc *STRIDE_pick_next(struct runqueue *rq, int cpu)
+{
+    struct proc *p = cpu != rq->cpu ? steal_from_heap(&rq->stride, cpu) : heapPop(&rq->stride);
+    if (p != 0 && p->pass > rq->stride_pass)
+        rq->stride_pass = p->pass;
+    return p;
+}
+
+// The stride is derived from the current priority, so a
+// set_priority() takes effect from the next tick.
+static int STRIDE_tick(struct proc *p)
+{
+    p->pass += STRIDE1 / STRIDE_TICKETS(p->priority);
+    return 0;
+}
+
+// ------------------- EDF -------------------
+// Periodic real-time processes. set_deadline() gives a process a
+// runtime budget for every period and a deadline within the period.
+// The process with the earliest absolute deadline runs first, and
+// EDF processes run before the processes of every other class.
+// A process that uses up its budget is throttled until its next
+// period begins, so it can't take more than its reserved share.
+
+#define EDF_BW_UNIT (1 << 20) // bandwidth of a process that needs the whole CPU
+
+struct spinlock edf_lock;
+uint64 edf_bw; // total bandwidth reserved, protected by edf_lock
+
+// Count a miss if the current job still wants the CPU at its deadline.
+static void edf_check_miss(struct proc *p)
+{
+    if (!p->edf_missed && (int)(ticks - p->edf_abs_deadline) >= 0)
+    {
+        p->edf_missed = 1;
+        p->performance.deadline_misses++;
+    }
+}
+
+// Start a new job, with a new period beginning now.
+// p->lock must be held, or p must be queued and rq->lock held.
+void edf_new_job(struct proc *p)
+{
+    p->edf_abs_deadline = ticks + p->edf_deadline;
+    p->edf_period_end = ticks + p->edf_period;
+    p->edf_budget = p->edf_runtime;
+    p->edf_missed = 0;
+}
+
+// A throttled process that is still RUNNABLE has not finished its
+// job, so it may miss the deadline before it gets a new budget.
+static void edf_replenish(struct proc *p)
+{
+    if (p->edf_budget <= 0)
+        edf_check_miss(p);
+    edf_new_job(p);
+}
+
+static void EDF_enqueue(struct runqueue *rq, struct proc *p)
+{
+    if ((int)(ticks - p->edf_period_end) >= 0)
+        edf_replenish(p);
+    if (p->edf_budget > 0)
+        heapPush(&rq->edf, p, p->edf_abs_deadline);
+    else
+        enqueue(&rq->edf_throttled, p);
+}
+
+static void EDF_dequeue(struct runqueue *rq, struct proc *p)
+{
+    heapRemove(&rq->edf, p);
+    removeFromQueue(&rq->edf_throttled, p);
+}
+
+// Move the throttled processes whose next period has begun back to
+// the heap. The CPU does it when it looks for work, and sched_tick()
+// on every tick, so a new job preempts whatever else is running.
+// rq->lock must be held.
+static void edf_unthrottle(struct runqueue *rq)
+{
+    struct proc *p;
+
+    for (int n = rq->edf_throttled.size; n > 0; n--)
+    {
+        p = dequeue(&rq->edf_throttled);
+        if ((int)(ticks - p->edf_period_end) >= 0)
+        {
+            edf_replenish(p);
+            heapPush(&rq->edf, p, p->edf_abs_deadline);
+        }
+        else
+        {
+            enqueue(&rq->edf_throttled, p);
+        }
+    }
+}
+
+static struct proc *EDF_pick_next(struct runqueue *rq, int cpu)
+{
+    struct proc *p;
+
+    edf_unthrottle(rq);
+    p = cpu != rq->cpu ? steal_from_heap(&rq->edf, cpu) : heapPop(&rq->edf);
+    if (p != 0)
+        edf_check_miss(p);
+    return p;
+}
+
+// A throttled process is queued but not ready to run.
+static int EDF_preempt(struct proc *p, struct proc *curr)
+{
+    return p->edf_budget > 0 && p->edf_abs_deadline < curr->edf_abs_deadline;
+}
+
+static int EDF_tick(struct proc *p)
+{
+    struct runqueue *rq = &runqueues[cpuid()];
+
+    edf_check_miss(p);
+    if (--p->edf_budget <= 0)
+    {
+        p->performance.overruns++;
+        return 1;
+    }
+
+    // let a process with an earlier deadline run (unlocked hint).
+    if (rq->edf.size > 0 && rq->edf.array[0].key < p->edf_abs_deadline)
+        return 1;
+    return 0;
+}
+
+// Admission control: reserve runtime / period of the CPU for p,
+// replacing what p had reserved before. Fails if the reservations
+// of all EDF processes would add up to more than one CPU.
+// p->lock must be held.
+int sched_edf_admit(struct proc *p, int runtime, int period)
+{
+    uint64 bw = (uint64)runtime * EDF_BW_UNIT / period;
+
+    acquire(&edf_lock);
+    if (edf_bw - p->edf_bw + bw > EDF_BW_UNIT)
+    {
+        release(&edf_lock);
+        return -1;
+    }
+    edf_bw = edf_bw - p->edf_bw + bw;
+    p->edf_bw = bw;
+    release(&edf_lock);
+    return 0;
+}
+
+// Give back the bandwidth p reserved, if any.
+void sched_edf_release(struct proc *p)
+{
+    acquire(&edf_lock);
+    edf_bw -= p->edf_bw;
+    p->edf_bw = 0;
+    release(&edf_lock);
+}
+
+struct sched_class sched_classes[NSCHED] = {
+    [SCHED_DEFAULT] {"DEFAULT", SCHED_DEFAULT, default_enqueue, default_dequeue, default_pick_next, slice_tick, 0},
+    [SCHED_FCFS] {"FCFS", SCHED_FCFS, FCFS_enqueue, FCFS_dequeue, FCFS_pick_next, FCFS_tick, 0},
+    [SCHED_SRT] {"SRT", SCHED_SRT, SRT_enqueue, SRT_dequeue, SRT_pick_next, slice_tick, SRT_preempt},
+    [SCHED_CFSD] {"CFSD", SCHED_CFSD, CFSD_enqueue, CFSD_dequeue, CFSD_pick_next, slice_tick, CFSD_preempt},
+    [SCHED_MLFQ] {"MLFQ", SCHED_MLFQ, MLFQ_enqueue, MLFQ_dequeue, MLFQ_pick_next, MLFQ_tick, MLFQ_preempt},
+    [SCHED_STRIDE] {"STRIDE", SCHED_STRIDE, STRIDE_enqueue, STRIDE_dequeue, STRIDE_pick_next, STRIDE_tick, 0},
+    [SCHED_EDF] {"EDF", SCHED_EDF, EDF_enqueue, EDF_dequeue, EDF_pick_next, EDF_tick, EDF_preempt},
+};
+
+// The order in which scheduler() asks the classes for work:
+// real-time first, then latency sensitive classes, batch classes last.
+static int pick_order[NSCHED] = {SCHED_EDF, SCHED_SRT, SCHED_FCFS, SCHED_MLFQ, SCHED_STRIDE, SCHED_CFSD, SCHED_DEFAULT};
+
+// Policy of the processes that follow the system default.
+// SCHEDFLAG picks it at build time, set_policy() changes it at run time.
+#if defined(FCFS)
+int sched_policy = SCHED_FCFS;
+#elif defined(SRT)
+int sched_policy = SCHED_SRT;
+#elif defined(CFSD)
+int sched_policy = SCHED_CFSD;
+#elif defined(MLFQ)
+int sched_policy = SCHED_MLFQ;
+#elif defined(STRIDE)
+int sched_policy = SCHED_STRIDE;
+#else
+int sched_policy = SCHED_DEFAULT;
+#endif
+
+// initialize the run queues at boot time.
+void schedinit(void)
+{
+    for (int i = 0; i < NCPU; i++)
+    {
+        struct runqueue *rq = &runqueues[i];
+        initlock(&rq->lock, "runqueue");
+        rq->cpu = i;
+        for (int j = 0; j < NSCHED; j++)
+            rq->nr_running[j] = 0;
+        rq->load = 0;
+        initQueue(&rq->rr);
+        initQueue(&rq->fcfs);
+        initHeap(&rq->srt);
+        initCFSRunQueue(&rq->cfs);
+        for (int j = 0; j < MLFQ_LEVELS; j++)
+            initQueue(&rq->mlfq[j]);
+        rq->mlfq_epoch = 0;
+        initHeap(&rq->stride);
+        rq->stride_pass = 0;
+        initHeap(&rq->edf);
+        initQueue(&rq->edf_throttled);
+    }
+    initlock(&edf_lock, "edf");
+    edf_bw = 0;
+}
+
+// EDF needs per-process parameters, so it can't be the default.
+int sched_set_default(int policy)
+{
+    if (policy < 0 || policy >= NSCHED || policy == SCHED_EDF)
+        return -1;
+    sched_policy = policy;
+    return 0;
+}
+
+// Set up the scheduling state of p, a newly allocated process.
+void sched_proc_init(struct proc *p)
+{
+    p->priority = Normal_Priority;
+    p->vruntime = 0;
+    p->burst_avg = (uint64)QUANTUM * TIMER_INTERVAL * 100;
+    p->timeslice = 0;
+    p->policy = SCHED_SYSTEM;
+    p->sched_class = 0;
+    p->rq_cpu = -1;
+    p->mlfq_level = 0;
+    p->mlfq_epoch = 0;
+    p->mlfq_used = 0;
+    p->pass = 0;
+    p->edf_runtime = 0;
+    p->edf_period = 0;
+    p->edf_deadline = 0;
+    p->edf_bw = 0;
+    p->edf_budget = 0;
+    p->edf_abs_deadline = 0;
+    p->edf_period_end = 0;
+    p->edf_missed = 0;
+    p->affinity = ~0UL;
+    p->last_cpu = -1;
+}
+
+// Account for a CPU burst of p that has just ended, burst r_time()
+// units long: charge it to p's vruntime, weighted by p's priority,
+// and to its MLFQ timeslice, and fold it into p's burst estimate,
+// which is kept in fixed point with two decimal places.
+void sched_burst_end(struct proc *p, uint64 burst)
+{
+    p->vruntime += burst * p->priority;
+    if (p->sched_class != 0 && p->sched_class->policy == SCHED_MLFQ)
+        mlfq_charge(p, burst);
+    p->burst_avg = ALPHA * burst + ((100 - ALPHA) * p->burst_avg) / 100;
+    p->performance.bursttime = burst / TIME_PER_US;
+    p->performance.average_bursttime = p->burst_avg / 100 / TIME_PER_US;
+}
+
+// How long p may run when it is dispatched before the timer preempts
+// it, in r_time() units, see base_timeslice(); MLFQ gives each level
+// a longer timeslice, less what p has used of it. 0 if p's class
+// doesn't preempt on time: FCFS runs processes until they block and
+// EDF until their budget runs out.
+uint64 sched_timeslice(struct proc *p)
+{
+    int policy = sched_policy_of(p);
+    uint64 slice = base_timeslice(p);
+
+    if (policy == SCHED_FCFS || policy == SCHED_EDF)
+        return 0;
+    if (policy == SCHED_MLFQ)
+    {
+        // the timeslice may have shrunk since p used part of it.
+        slice <<= p->mlfq_level;
+        return slice > p->mlfq_used ? slice - p->mlfq_used : 1;
+    }
+    return slice;
+}
+
+// The policy p is scheduled under.
+int sched_policy_of(struct proc *p)
+{
+    return p->policy == SCHED_SYSTEM ? sched_policy : p->policy;
+}
+
+// The CPU whose run queue p goes on: the CPU that made p runnable,
+// if p may run there, else the CPU p last ran on, if p may still
+// run there, else the first running CPU p may run on.
+static int place(struct proc *p)
+{
+    int id = cpuid();
+
+    if ((p->affinity >> id) & 1)
+        return id;
+    if (p->last_cpu >= 0 && ((p->affinity >> p->last_cpu) & 1))
+        return p->last_cpu;
+    for (int i = 0; i < NCPU; i++)
+        if (((p->affinity >> i) & 1) && cpus[i].start != 0)
+            return i;
+    return id;
+}
+
+// Load weight of p: its stride tickets, so a high priority
+// process counts as more load than a low priority one.
+static int load_weight(struct proc *p)
+{
+    return STRIDE_TICKETS(p->priority);
+}
+
+// Add p to rq under class. rq->lock must be held.
+static void rq_add(struct runqueue *rq, struct sched_class *class, struct proc *p)
+{
+    class->enqueue(rq, p);
+    rq->nr_running[class->policy]++;
+    p->rq_weight = load_weight(p);
+    rq->load += p->rq_weight;
+    p->sched_class = class;
+    p->rq_cpu = rq->cpu;
+}
+
+// Account for p, which its class has just taken off rq.
+// rq->lock must be held.
+static void rq_removed(struct runqueue *rq, struct proc *p)
+{
+    rq->nr_running[p->sched_class->policy]--;
+    rq->load -= p->rq_weight;
+    p->rq_cpu = -1;
+}
+
+// Position of policy in pick_order.
+static int class_rank(int policy)
+{
+    int i;
+
+    for (i = 0; i < NSCHED - 1 && pick_order[i] != policy; i++)
+        ;
+    return i;
+}
+
+// Whether p, just queued, should run at once rather than when the
+// timeslice of curr ends: its class comes first in pick_order, or
+// its class says it is more urgent than curr.
+static int preempts(struct proc *p, struct proc *curr)
+{
+    struct sched_class *class = p->sched_class;
+    int rank = class_rank(class->policy);
+    int curr_rank = class_rank(curr->sched_class->policy);
+
+    if (rank != curr_rank)
+        return rank < curr_rank;
+    return class->preempt != 0 && class->preempt(p, curr);
+}
+
+// Get p, just queued on cpu's run queue, running as soon as possible:
+// wake cpu if it is idle, else wake an idle CPU that may run p, so it
+// steals p, else preempt the process cpu runs if p is more urgent.
+// Otherwise p waits until a CPU looks for work on its own.
+// Reads the other CPUs' current processes without locks; a stale
+// read costs a needless reschedule or up to a tick of latency.
+static void check_preempt(int cpu, struct proc *p)
+{
+    struct proc *curr = cpus[cpu].proc;
+
+    if (curr == 0)
+    {
+        // this CPU is in scheduler() and will find p itself.
+        if (cpu != cpuid())
+            resched_cpu(cpu);
+        return;
+    }
+    if (curr == p)
+        return;
+    for (int i = 0; i < NCPU; i++)
+    {
+        if (i != cpu && cpus[i].start != 0 && cpus[i].proc == 0 && runs_on(p, i))
+        {
+            resched_cpu(i);
+            return;
+        }
+    }
+    if (preempts(p, curr))
+        resched_cpu(cpu);
+}
+
+// Put p, which has just become RUNNABLE, on a run queue of a CPU
+// it may run on, see place(), under the class of its policy, and
+// see that it runs soon, see check_preempt().
+// p->lock must be held.
+void sched_enqueue(struct proc *p)
+{
+    struct runqueue *rq = &runqueues[place(p)];
+
+    acquire(&rq->lock);
+    rq_add(rq, &sched_classes[sched_policy_of(p)], p);
+    release(&rq->lock);
+    check_preempt(rq->cpu, p);
+}
+
+// Move a RUNNABLE process to the class of its current policy.
+// If a CPU has already taken p off its run queue, p is about
+// to run and the new policy applies from its next enqueue.
+// p->lock must be held.
+void sched_requeue(struct proc *p)
+{
+    if (p->state != RUNNABLE)
+        return;
+
+    // the load balancer may move p while we wait for the lock.
+    for (;;)
+    {
+        int cpu = p->rq_cpu;
+        if (cpu < 0)
+            return;
+        struct runqueue *rq = &runqueues[cpu];
+        acquire(&rq->lock);
+        if (p->rq_cpu == cpu)
+        {
+            p->sched_class->dequeue(rq, p);
+            rq_removed(rq, p);
+            release(&rq->lock);
+            break;
+        }
+        release(&rq->lock);
+    }
+
+    sched_enqueue(p);
+}
+
+// Take the next process of the given class to run on cpu off rq.
+// rq->lock must be held.
+static struct proc *pick_from(struct runqueue *rq, struct sched_class *class, int cpu)
+{
+    struct proc *p = class->pick_next(rq, cpu);
+    if (p != 0)
+        rq_removed(rq, p);
+    return p;
+}
+
+// Remove and return the process this CPU should run next, or 0.
+// A class with nothing queued here takes work of the same class
+// from the peer that has the most of it queued, skipping processes
+// whose affinity excludes this CPU. The unlocked counts are only
+// hints; pick_next() rechecks under the lock.
+struct proc *sched_pick_next(void)
+{
+    int id = cpuid();
+    struct runqueue *rq = &runqueues[id];
+    struct proc *p = 0;
+
+    acquire(&rq->lock);
+    for (int i = 0; p == 0 && i < NSCHED; i++)
+    {
+        if (rq->nr_running[pick_order[i]] > 0)
+            p = pick_from(rq, &sched_classes[pick_order[i]], id);
+    }
+    release(&rq->lock);
+
+    for (int i = 0; p == 0 && i < NSCHED; i++)
+    {
+        int policy = pick_order[i];
+        struct runqueue *busiest = 0;
+        for (int j = 1; j < NCPU; j++)
+        {
+            struct runqueue *peer = &runqueues[(id + j) % NCPU];
+            if (peer->nr_running[policy] > 0 &&
+                (busiest == 0 || peer->nr_running[policy] > busiest->nr_running[policy]))
+                busiest = peer;
+        }
+        if (busiest != 0)
+        {
+            acquire(&busiest->lock);
+            p = pick_from(busiest, &sched_classes[policy], id);
+            release(&busiest->lock);
+        }
+    }
+
+    return p;
+}
+
+// Move one queued process from src to dst, preferring the classes
+// scheduler() asks last, whose processes are the least latency
+// sensitive. Returns 0 if every queued process is pinned elsewhere.
+static int migrate_one(struct runqueue *src, struct runqueue *dst)
+{
+    struct proc *p = 0;
+
+    // take the two locks in index order, so two CPUs never wait on each other.
+    struct runqueue *first = src->cpu < dst->cpu ? src : dst;
+    struct runqueue *second = src->cpu < dst->cpu ? dst : src;
+    acquire(&first->lock);
+    acquire(&second->lock);
+    for (int i = NSCHED - 1; p == 0 && i >= 0; i--)
+    {
+        struct sched_class *class = &sched_classes[pick_order[i]];
+        if (src->nr_running[class->policy] > 0 && (p = pick_from(src, class, dst->cpu)) != 0)
+            rq_add(dst, class, p);
+    }
+    release(&second->lock);
+    release(&first->lock);
+    return p != 0;
+}
+
+// Even out the run queues, called from clockintr() every
+// BALANCE_INTERVAL ticks. The load of a CPU is the weight of its
+// queued processes plus the one it runs. Processes move from the
+// busiest CPU to the idlest while the busiest has at least two more
+// processes and more than BALANCE_PCT percent more load. Moving one
+// process narrows the length gap by two, so a move never turns the
+// imbalance around and processes don't bounce back and forth.
+// Reads the other CPUs' counts without their locks; they are hints.
+void sched_balance(void)
+{
+    for (int moves = 0; moves < NPROC; moves++)
+    {
+        int busiest = -1, idlest = -1;
+        int load[NCPU], len[NCPU];
+
+        for (int i = 0; i < NCPU; i++)
+        {
+            struct runqueue *rq = &runqueues[i];
+            struct proc *running = cpus[i].proc;
+            if (cpus[i].start == 0)
+                continue;
+            load[i] = rq->load;
+            len[i] = 0;
+            for (int j = 0; j < NSCHED; j++)
+                len[i] += rq->nr_running[j];
+            if (running != 0)
+            {
+                load[i] += load_weight(running);
+                len[i]++;
+            }
+            if (busiest < 0 || load[i] > load[busiest])
+                busiest = i;
+            if (idlest < 0 || load[i] < load[idlest])
+                idlest = i;
+        }
+
+        if (busiest == idlest || len[busiest] - len[idlest] < 2 ||
+            load[busiest] * 100 <= load[idlest] * (100 + BALANCE_PCT))
+            return;
+        if (!migrate_one(&runqueues[busiest], &runqueues[idlest]))
+            return;
+    }
+}
+
+// Aging for SRT and CFSD, whose order alone can starve a long
+// burst or a heavy vruntime behind a stream of short ones.
+// The key of a queued process shrinks in proportion to how long it
+// has been RUNNABLE, towards the front of its queue, which it reaches
+// after MAX_WAIT ticks. The key is recomputed from the process's own
+// burst estimate and vruntime, which don't change while it waits, so
+// repeated passes don't compound, and the boost ends when it runs.
+
+// Scale key towards floor as p's wait approaches MAX_WAIT.
+static uint64 aged_key(struct proc *p, uint64 floor, uint64 key)
+{
+    uint waited = ticks - p->state_tick;
+
+    if (key <= floor)
+        return key;
+    if (waited >= MAX_WAIT)
+        return floor;
+    return floor + (key - floor) * (MAX_WAIT - waited) / MAX_WAIT;
+}
+
+static void age_runqueue(struct runqueue *rq)
+{
+    for (int i = 0; i < rq->srt.size; i++)
+    {
+        struct HeapNode *node = &rq->srt.array[i];
+        node->key = aged_key(node->proc, 0, node->proc->burst_avg);
+    }
+    heapify(&rq->srt);
+
+    // an aged node only moves left, behind the nodes still to visit.
+    struct rb_node *node = rb_first(&rq->cfs.tree);
+    while (node != 0)
+    {
+        struct rb_node *next = rb_next(node);
+        struct proc *p = rb_entry(node, struct proc, rb_node);
+        uint64 key = aged_key(p, rq->cfs.min_vruntime, p->vruntime);
+        if (key < node->key)
+        {
+            rb_erase(&rq->cfs.tree, node);
+            node->key = key;
+            rb_insert(&rq->cfs.tree, node);
+        }
+        node = next;
+    }
+}
+
+// Age the queued SRT and CFSD processes of every CPU,
+// called from clockintr() every AGE_INTERVAL ticks.
+void sched_age(void)
+{
+    for (int i = 0; i < NCPU; i++)
+    {
+        struct runqueue *rq = &runqueues[i];
+        if (rq->nr_running[SCHED_SRT] == 0 && rq->nr_running[SCHED_CFSD] == 0)
+            continue;
+        acquire(&rq->lock);
+        age_runqueue(rq);
+        release(&rq->lock);
+    }
+}
+
+// Called on each timer interrupt while p is RUNNING.
+// Returns 1 if p should give up the CPU.
+int sched_tick(struct proc *p)
+{
+    struct runqueue *rq = &runqueues[cpuid()];
+
+    if (rq->edf_throttled.size > 0)
+    {
+        acquire(&rq->lock);
+        edf_unthrottle(rq);
+        release(&rq->lock);
+    }
+
+    if (p->sched_class->tick(p))
+        return 1;
+
+    // an EDF process that is ready runs before every other class (unlocked hint).
+    return p->sched_class->policy != SCHED_EDF && rq->edf.size > 0;
+}
@@ -0,0 +1,85 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+// Scheduling policies, for set_policy().
+#define SCHED_DEFAULT 0 // round robin
+#define SCHED_FCFS 1    // first come first served, never preempted
+#define SCHED_SRT 2     // shortest average burst time first
+#define SCHED_CFSD 3    // smallest weighted vruntime first
+#define SCHED_MLFQ 4    // multi-level feedback queue
+#define SCHED_STRIDE 5  // stride scheduling, shares in proportion to tickets
+#define SCHED_EDF 6     // earliest deadline first, set by set_deadline()
+#define NSCHED 7        // number of scheduling policies
+
+#define SCHED_SYSTEM -1 // follow the system default policy
+
+#define SET_POLICY_SYSTEM 0 // set_policy() pid that changes the system default
+
+// Time accounting of a process, for wait_stat().
+struct perf
+{
+    int ctime;             // process creation time
+    int ttime;             // process termination time
+    int stime;             // the total time the process spent in the SLEEPING state
+    int retime;            // the total time the process spent in the RUNNABLE state
+    int rutime;            // the total time the process spent in the RUNNING state
+    int bursttime;         // process burst time
+    int average_bursttime; // approximate estimated burst time, in microseconds
+    int deadline_misses;   // EDF jobs that still wanted the CPU at their deadline
+    int overruns;          // EDF periods whose runtime budget ran out
+    int migrations;        // times the process ran on a different hart than before
+    int starvations;       // times the process waited MAX_WAIT ticks or more to run
+};
+
+// Time accounting of a hart, for cpustat(), in r_time() units.
+struct cpustat
+{
+    uint64 total; // time since the hart started scheduling
+    uint64 idle;  // time the hart spent waiting for interrupts
+};
+
+// Counters of a CPU bandwidth group, for cpugroup_stat().
+struct cpugroup_stat
+{
+    int quota;             // ticks of CPU time the group may use per period
+    int period;            // ticks
+    int nprocs;            // processes in the group
+    int throttled;         // whether the group has used up its quota
+    uint64 usage;          // CPU time used, in r_time() units
+    uint64 periods;        // periods that have ended
+    uint64 nthrottled;     // periods in which the quota ran out
+    uint64 throttled_time; // ticks spent throttled
+};
+
+// Stride scheduling tickets of a set_priority() priority, 1 to 5.
+// Priority 1 gets five times the CPU time of priority 5.
+#define STRIDE_TICKETS(priority) (100 * (6 - (priority)))
+
+// Scheduler trace events, for sched_trace_read().
+#define SCHED_EV_NEW 0      // a new process became RUNNABLE
+#define SCHED_EV_DISPATCH 1 // RUNNABLE to RUNNING
+#define SCHED_EV_PREEMPT 2  // RUNNING to RUNNABLE
+#define SCHED_EV_SLEEP 3    // RUNNING to SLEEPING
+#define SCHED_EV_WAKEUP 4   // SLEEPING to RUNNABLE
+#define SCHED_EV_MIGRATE 5  // dispatched on another hart than last time
+#define SCHED_EV_EXIT 6     // RUNNING to ZOMBIE
+#define SCHED_NEV 7         // number of event types
+
+// One scheduler trace record.
+// metric is what the policy orders the process by: its vruntime
+// in microseconds under CFSD, its average burst in microseconds
+// under every other policy.
+struct sched_event
+{
+    uint64 time;     // r_time() of the event
+    int pid;         // process the event happened to
+    int metric;      // policy metric after the event
+    uchar cpu;       // hart that recorded the event
+    uchar prev_cpu;  // hart the process last ran on, 0xff if none
+    uchar type;      // SCHED_EV_*
+    uchar policy;    // policy the process is scheduled under
+    uchar old_state; // procstate before the event
+    uchar new_state; // procstate after the event
+};
+
+#endif
@@ -0,0 +1,160 @@
+// Scheduler event trace.
+//
+// Every hart records the scheduling events it performs into a ring
+// of its own, so recording takes no lock: only the owning hart
+// writes its ring, always with interrupts off, and it publishes a
+// record by advancing head after filling it in. The reader frees
+// records by advancing tail after copying them out. A full ring
+// drops new events and counts them rather than overwriting records
+// the reader may be copying.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "rbtree.h"
+#include "proc.h"
+#include "sched.h"
+#include "defs.h"
+
+struct trace_ring
+{
+    uint head;    // next record to fill, written by the owning hart
+    uint tail;    // next record to read, written by the reader
+    uint dropped; // events lost to a full ring, written by the owning hart
+    uint seen;    // dropped when tracing was last started, for the reader
+    struct sched_event ev[TRACE_SIZE];
+};
+
+static struct trace_ring rings[NCPU];
+static int tracing;
+
+// Serializes readers, the rings' writers never take it.
+static struct spinlock trace_lock;
+
+void schedtraceinit(void)
+{
+    initlock(&trace_lock, "schedtrace");
+}
+
+// Record an event of p, whose state has just changed from old
+// to p->state. p->lock must be held, so interrupts are off and
+// this hart owns its ring until the record is published.
+void sched_trace_event(struct proc *p, int type, int old)
+{
+    if (!tracing)
+        return;
+
+    struct trace_ring *r = &rings[cpuid()];
+    uint head = r->head;
+
+    if (head - r->tail >= TRACE_SIZE)
+    {
+        r->dropped++;
+        return;
+    }
+
+    struct sched_event *e = &r->ev[head % TRACE_SIZE];
+    e->time = r_time();
+    e->pid = p->pid;
+    e->policy = sched_policy_of(p);
+    if (e->policy == SCHED_CFSD)
+        e->metric = p->vruntime / TIME_PER_US;
+    else
+        e->metric = p->performance.average_bursttime;
+    e->cpu = cpuid();
+    e->prev_cpu = p->last_cpu < 0 ? 0xff : p->last_cpu;
+    e->type = type;
+    e->old_state = old;
+    e->new_state = p->state;
+
+    // the record must be complete before the reader can see it.
+    __sync_synchronize();
+    r->head = head + 1;
+}
+
+// Record the state change of p from old to p->state,
+// if it is one of the scheduling events.
+void sched_trace_state(struct proc *p, int old)
+{
+    int type;
+
+    if (old == RUNNABLE && p->state == RUNNING)
+        type = SCHED_EV_DISPATCH;
+    else if (old == RUNNING && p->state == RUNNABLE)
+        type = SCHED_EV_PREEMPT;
+    else if (old == RUNNING && p->state == SLEEPING)
+        type = SCHED_EV_SLEEP;
+    else if (old == SLEEPING && p->state == RUNNABLE)
+        type = SCHED_EV_WAKEUP;
+    else if (old == USED && p->state == RUNNABLE)
+        type = SCHED_EV_NEW;
+    else if (old == RUNNING && p->state == ZOMBIE)
+        type = SCHED_EV_EXIT;
+    else
+        return;
+    sched_trace_event(p, type, old);
+}
+
+// Start tracing with empty rings when on is set, stop it otherwise.
+// Returns the number of events dropped since tracing last started.
+int sched_trace(int on)
+{
+    int dropped = 0;
+
+    acquire(&trace_lock);
+    for (int i = 0; i < NCPU; i++)
+    {
+        struct trace_ring *r = &rings[i];
+        uint now = r->dropped;
+        dropped += now - r->seen;
+        if (on)
+        {
+            r->seen = now;
+            r->tail = r->head;
+        }
+    }
+    tracing = on;
+    release(&trace_lock);
+    return dropped;
+}
+
+// Copy up to n buffered events to the user array at addr, oldest
+// first within each hart. Returns the number copied, or -1 if
+// tracing is stopped and every ring has been drained.
+int sched_trace_read(uint64 addr, int n)
+{
+    struct proc *p = myproc();
+    int copied = 0;
+    int pending = 0;
+
+    acquire(&trace_lock);
+    for (int i = 0; i < NCPU; i++)
+    {
+        struct trace_ring *r = &rings[i];
+        uint tail = r->tail;
+        uint head = r->head;
+
+        // read the records only after seeing head.
+        __sync_synchronize();
+        for (; tail != head && copied < n; tail++, copied++)
+        {
+            if (copyout(p->pagetable, addr + copied * sizeof(struct sched_event),
+                        (char *)&r->ev[tail % TRACE_SIZE], sizeof(struct sched_event)) < 0)
+            {
+                release(&trace_lock);
+                return -1;
+            }
+        }
+        pending += head - tail;
+
+        // the records must be copied before the writer may reuse them.
+        __sync_synchronize();
+        r->tail = tail;
+    }
+    if (copied == 0 && pending == 0 && !tracing)
+        copied = -1;
+    release(&trace_lock);
+    return copied;
+}
@@ -3,6 +3,7 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "rbtree.h"
 #include "proc.h"
 #include "syscall.h"
 #include "defs.h"
@@ -103,6 +104,18 @@ extern uint64 sys_uptime(void);
 extern uint64 sys_trace(void);
 extern uint64 sys_wait_stat(void);
 extern uint64 sys_set_priority(void);
+extern uint64 sys_set_policy(void);
+extern uint64 sys_set_deadline(void);
+extern uint64 sys_cpustat(void);
+extern uint64 sys_sched_setaffinity(void);
+extern uint64 sys_sched_getaffinity(void);
+extern uint64 sys_sched_trace(void);
+extern uint64 sys_sched_trace_read(void);
+extern uint64 sys_sched_settimeslice(void);
+extern uint64 sys_sched_gettimeslice(void);
+extern uint64 sys_cpugroup_create(void);
+extern uint64 sys_cpugroup_join(void);
+extern uint64 sys_cpugroup_stat(void);
 
 static uint64 (*syscalls[])(void) = {
     [SYS_fork] sys_fork,
@@ -129,9 +142,21 @@ static uint64 (*syscalls[])(void) = {
     [SYS_trace] sys_trace,
     [SYS_wait_stat] sys_wait_stat,
     [SYS_set_priority] sys_set_priority,
+    [SYS_set_policy] sys_set_policy,
+    [SYS_set_deadline] sys_set_deadline,
+    [SYS_cpustat] sys_cpustat,
+    [SYS_sched_setaffinity] sys_sched_setaffinity,
+    [SYS_sched_getaffinity] sys_sched_getaffinity,
+    [SYS_sched_trace] sys_sched_trace,
+    [SYS_sched_trace_read] sys_sched_trace_read,
+    [SYS_sched_settimeslice] sys_sched_settimeslice,
+    [SYS_sched_gettimeslice] sys_sched_gettimeslice,
+    [SYS_cpugroup_create] sys_cpugroup_create,
+    [SYS_cpugroup_join] sys_cpugroup_join,
+    [SYS_cpugroup_stat] sys_cpugroup_stat,
 };
 
-char *sys_names[24] = {
+char *sys_names[36] = {
     "fork",
     "exit",
     "wait",
@@ -156,6 +181,18 @@ char *sys_names[24] = {
     "trace",
     "wait_stat",
     "set_priority",
+    "set_policy",
+    "set_deadline",
+    "cpustat",
+    "sched_setaffinity",
+    "sched_getaffinity",
+    "sched_trace",
+    "sched_trace_read",
+    "sched_settimeslice",
+    "sched_gettimeslice",
+    "cpugroup_create",
+    "cpugroup_join",
+    "cpugroup_stat",
 };
 
 void syscall(void)
@@ -169,7 +206,8 @@ void syscall(void)
         int arg;
         argint(0, &arg);
         p->trapframe->a0 = syscalls[num]();
-        if ((p->mask & 1 << num) > 0)
+        // the trace mask has bits for the first 32 syscalls only.
+        if (num < 32 && (((uint)p->mask >> num) & 1))
         {
             if (num == 1)
             {
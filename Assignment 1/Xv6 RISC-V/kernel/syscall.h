@@ -22,4 +22,16 @@
 #define SYS_close 21
 #define SYS_trace 22
 #define SYS_wait_stat 23
-#define SYS_set_priority 24
\ No newline at end of file
+#define SYS_set_priority 24
+#define SYS_set_policy 25
+#define SYS_set_deadline 26
+#define SYS_cpustat 27
+#define SYS_sched_setaffinity 28
+#define SYS_sched_getaffinity 29
+#define SYS_sched_trace 30
+#define SYS_sched_trace_read 31
+#define SYS_sched_settimeslice 32
+#define SYS_sched_gettimeslice 33
+#define SYS_cpugroup_create 34
+#define SYS_cpugroup_join 35
+#define SYS_cpugroup_stat 36
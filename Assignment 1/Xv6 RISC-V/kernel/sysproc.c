@@ -5,6 +5,7 @@
 #include "param.h"
 #include "memlayout.h"
 #include "spinlock.h"
+#include "rbtree.h"
 #include "proc.h"
 
 uint64
@@ -131,4 +132,145 @@ sys_set_priority(void)
     if (argint(0, &priority) < 0)
         return -1;
     return set_priority(priority);
-}
\ No newline at end of file
+}
+
+uint64
+sys_set_policy(void)
+{
+    int policy;
+    int pid;
+    if (argint(0, &policy) < 0)
+        return -1;
+    if (argint(1, &pid) < 0)
+        return -1;
+    return set_policy(policy, pid);
+}
+
+uint64
+sys_set_deadline(void)
+{
+    int runtime;
+    int period;
+    int deadline;
+    if (argint(0, &runtime) < 0)
+        return -1;
+    if (argint(1, &period) < 0)
+        return -1;
+    if (argint(2, &deadline) < 0)
+        return -1;
+    return set_deadline(runtime, period, deadline);
+}
+
+uint64
+sys_cpustat(void)
+{
+    uint64 st;
+    int n;
+    if (argaddr(0, &st) < 0)
+        return -1;
+    if (argint(1, &n) < 0)
+        return -1;
+    return cpustat(st, n);
+}
+
+uint64
+sys_sched_setaffinity(void)
+{
+    int pid;
+    uint64 mask;
+    if (argint(0, &pid) < 0)
+        return -1;
+    if (argaddr(1, &mask) < 0)
+        return -1;
+    return set_affinity(pid, mask);
+}
+
+uint64
+sys_sched_getaffinity(void)
+{
+    int pid;
+    uint64 mask;
+    if (argint(0, &pid) < 0)
+        return -1;
+    if (argaddr(1, &mask) < 0)
+        return -1;
+    return get_affinity(pid, mask);
+}
+
+uint64
+sys_sched_trace(void)
+{
+    int on;
+    if (argint(0, &on) < 0)
+        return -1;
+    return sched_trace(on);
+}
+
+uint64
+sys_sched_trace_read(void)
+{
+    uint64 buf;
+    int n;
+    if (argaddr(0, &buf) < 0)
+        return -1;
+    if (argint(1, &n) < 0)
+        return -1;
+    return sched_trace_read(buf, n);
+}
+
+uint64
+sys_sched_settimeslice(void)
+{
+    int pid;
+    int us;
+    if (argint(0, &pid) < 0)
+        return -1;
+    if (argint(1, &us) < 0)
+        return -1;
+    return set_timeslice(pid, us);
+}
+
+uint64
+sys_sched_gettimeslice(void)
+{
+    int pid;
+    if (argint(0, &pid) < 0)
+        return -1;
+    return get_timeslice(pid);
+}
+
+uint64
+sys_cpugroup_create(void)
+{
+    int quota;
+    int period;
+    if (argint(0, &quota) < 0)
+        return -1;
+    if (argint(1, &period) < 0)
+        return -1;
+    return cpugroup_create(quota, period);
+}
+
+uint64
+sys_cpugroup_join(void)
+{
+    int pid;
+    int gid;
+    if (argint(0, &pid) < 0)
+        return -1;
+    if (argint(1, &gid) < 0)
+        return -1;
+    return cpugroup_join(pid, gid);
+}
+
+uint64
+sys_cpugroup_stat(void)
+{
+    int gid;
+    uint64 st;
+    if (argint(0, &gid) < 0)
+        return -1;
+    if (argaddr(1, &st) < 0)
+        return -1;
+    return cpugroup_stat(gid, st);
+}
@@ -3,6 +3,7 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "rbtree.h"
 #include "proc.h"
 #include "defs.h"
 
@@ -16,6 +17,18 @@ void kernelvec();
 
 extern int devintr();
 
+// in start.c, timervec's scratch areas.
+extern uint64 timer_scratch[NCPU][11];
+
+// The timer interrupt of p, the process running on this CPU.
+// The tick accounting of both its scheduling class and its CPU
+// bandwidth group must run. Returns 1 if p must yield.
+static int preempt_tick(struct proc *p)
+{
+    int throttled = cpugroup_tick(p);
+    return sched_tick(p) || throttled;
+}
+
 void trapinit(void)
 {
     initlock(&tickslock, "time");
@@ -78,21 +91,11 @@ void usertrap(void)
     if (p->killed)
         exit(-1);
 
-#ifndef FCFS
-    // give up the CPU if this is a timer interrupt.
-    if (which_dev == 2)
-    {
-        if (p->performance.bursttime == QUANTUM)
-        {
-            p->performance.bursttime = 0;
-            yield();
-        }
-        else
-        {
-            p->performance.bursttime += 1;
-        }
-    }
-#endif
+    // give up the CPU if this is a timer interrupt and the process's
+    // scheduling class or CPU bandwidth group says so, or if a more
+    // urgent process is waiting.
+    if ((which_dev == 2 && preempt_tick(p)) || need_resched())
+        yield();
 
     usertrapret();
 }
@@ -162,19 +165,12 @@ void kerneltrap()
         panic("kerneltrap");
     }
 
-#ifndef FCFS
-    // give up the CPU if this is a timer interrupt.
-    if (which_dev == 2 && myproc() != 0 && myproc()->state == RUNNING)
-    {
-        if (myproc()->performance.bursttime == QUANTUM)
-        {
-            myproc()->performance.bursttime = 0;
-            yield();
-        }
-        else
-            myproc()->performance.bursttime += 1;
-    }
-#endif
+    // give up the CPU if this is a timer interrupt and the process's
+    // scheduling class or CPU bandwidth group says so, or if a more
+    // urgent process is waiting.
+    if (myproc() != 0 && myproc()->state == RUNNING &&
+        ((which_dev == 2 && preempt_tick(myproc())) || need_resched()))
+        yield();
 
     // the yield() may have caused some traps to occur,
     // so restore trap registers for use by kernelvec.S's sepc instruction.
@@ -186,14 +182,48 @@ void clockintr()
 {
     acquire(&tickslock);
     ticks++;
-    update_process_times();
     wakeup(&ticks);
+    int balance = ticks % BALANCE_INTERVAL == 0;
+    int age = ticks % AGE_INTERVAL == 0;
     release(&tickslock);
+
+    if (balance)
+        sched_balance();
+    if (age)
+        sched_age();
+    cpugroup_refill();
+}
+
+// End the timeslice of the process this CPU is about to run at
+// r_time() deadline, or stop ending it when deadline is 0.
+// timervec also reprograms mtimecmp, for the ticks; if it does so
+// between the reads and writes here, the value written here is
+// stale, which only makes the timer fire early, and timervec then
+// programs it again. Interrupts must be off.
+void set_slice_timer(uint64 deadline)
+{
+    int id = cpuid();
+    uint64 *scratch = timer_scratch[id];
+
+    if (deadline == 0)
+    {
+        scratch[8] = 0;
+        return;
+    }
+
+    // an end of timeslice still pending is the previous process's.
+    scratch[9] = 0;
+    __sync_synchronize();
+    scratch[8] = deadline;
+    __sync_synchronize();
+    uint64 next = scratch[7];
+    *(uint64 *)CLINT_MTIMECMP(id) = deadline < next ? deadline : next;
 }
 
 // check if it's an external interrupt or software interrupt,
 // and handle it.
 // returns 2 if timer interrupt,
+// 3 if reschedule IPI or end of timeslice,
 // 1 if other device,
 // 0 if not recognized.
 int devintr()
@@ -231,18 +261,26 @@ int devintr()
     }
     else if (scause == 0x8000000000000001L)
     {
-        // software interrupt from a machine-mode timer interrupt,
-        // forwarded by timervec in kernelvec.S.
+        // software interrupt from a machine-mode timer interrupt
+        // or a reschedule IPI, forwarded by timervec in kernelvec.S.
+
+        // acknowledge the software interrupt by clearing
+        // the SSIP bit in sip, before looking at why it came,
+        // so a tick that arrives meanwhile raises it again.
+        w_sip(r_sip() & ~2);
+
+        // timervec marks the ticks and the ends of timeslices, the
+        // rest are IPIs. The trap return checks need_resched.
+        if (__sync_lock_test_and_set(&timer_scratch[cpuid()][9], 0) != 0)
+            resched_cpu(cpuid());
+        if (__sync_lock_test_and_set(&timer_scratch[cpuid()][6], 0) == 0)
+            return 3;
 
         if (cpuid() == 0)
         {
             clockintr();
         }
 
-        // acknowledge the software interrupt by clearing
-        // the SSIP bit in sip.
-        w_sip(r_sip() & ~2);
-
         return 2;
     }
     else
@@ -0,0 +1,319 @@
+// Host-side scheduler simulator.
+//
+// Runs a workload through kernel/sched.c, compiled for the host by
+// simkernel.c, on simulated harts, and reports how each policy did,
+// so a policy or ALPHA, QUANTUM and MAX_WAIT can be evaluated without
+// booting QEMU.
+//
+//   schedsim [-p POLICY] [-C harts] [-a alpha] [-q quantum] [-w max_wait]
+//            [-I ipi] [-c n] [-i n] [-n n] [-s ticks] [-r seed] [trace]
+//
+// The workload is read from trace, or generated: -c CPU bound, -i I/O
+// bound and -n interactive processes (default 1000 of each) arriving
+// over the first -s ticks (default 100), with random priorities. A
+// trace has one process per line,
+//   arrival priority burst [io burst]...
+// arrival in ticks, priority 1 to 5, each burst a CPU burst in
+// microseconds and each io the ticks the process sleeps in between.
+// Lines starting with # are comments.
+//
+// Without -p it runs DEFAULT, FCFS, SRT and CFSD in turn. Each run
+// prints one line of key=value pairs, times in seconds of simulated
+// time; fairness is Jain's index of rutime / turnaround and
+// wakeup_latency_ms the mean time from a wakeup until the process
+// runs. -I 0 turns off preemption on wakeup, as before reschedule
+// IPIs, to compare with.
+//
+// Build it on the host with make sim/schedsim.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kernel/types.h"
+#include "kernel/sched.h"
+#include "sim/sim.h"
+
+#define MAXBURSTS 1024 // bursts of one process in a trace
+
+static struct
+{
+    char *name;
+    int policy;
+} policies[] = {
+    {"DEFAULT", SCHED_DEFAULT},
+    {"FCFS", SCHED_FCFS},
+    {"SRT", SCHED_SRT},
+    {"CFSD", SCHED_CFSD},
+    {"MLFQ", SCHED_MLFQ},
+    {"STRIDE", SCHED_STRIDE},
+    {0, 0},
+};
+
+static struct sim_task *tasks;
+static int ntasks, cap;
+static unsigned long seed = 1;
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: schedsim [-p POLICY] [-C harts] [-a alpha] [-q quantum] [-w max_wait]\n"
+                    "                [-I ipi] [-c n] [-i n] [-n n] [-s ticks] [-r seed] [trace]\n");
+    exit(1);
+}
+
+// xorshift, so a seed gives the same workload with every C library.
+static int random_between(int lo, int hi)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return lo + seed % (hi - lo + 1);
+}
+
+static struct sim_task *new_task(int arrival, int priority, int nbursts)
+{
+    if (ntasks == cap)
+    {
+        cap = cap ? 2 * cap : 1024;
+        tasks = realloc(tasks, cap * sizeof(*tasks));
+    }
+    struct sim_task *t = &tasks[ntasks++];
+    memset(t, 0, sizeof(*t));
+    t->arrival = arrival;
+    t->priority = priority;
+    t->nbursts = nbursts;
+    t->burst = calloc(nbursts, sizeof(int));
+    t->io = calloc(nbursts, sizeof(int));
+    if (tasks == 0 || t->burst == 0 || t->io == 0)
+    {
+        fprintf(stderr, "schedsim: out of memory\n");
+        exit(1);
+    }
+    return t;
+}
+
+static void generate(int ncpu, int nio, int ninteractive, int spread)
+{
+    for (int i = 0; i < ncpu + nio + ninteractive; i++)
+    {
+        int arrival = random_between(0, spread > 0 ? spread - 1 : 0);
+        int priority = random_between(1, 5);
+        struct sim_task *t;
+
+        if (i < ncpu)
+        {
+            t = new_task(arrival, priority, 1);
+            t->burst[0] = random_between(50000, 1000000);
+        }
+        else if (i < ncpu + nio)
+        {
+            t = new_task(arrival, priority, random_between(10, 20));
+            for (int b = 0; b < t->nbursts; b++)
+            {
+                t->burst[b] = random_between(1000, 20000);
+                t->io[b] = random_between(1, 3);
+            }
+        }
+        else
+        {
+            t = new_task(arrival, priority, random_between(20, 50));
+            for (int b = 0; b < t->nbursts; b++)
+            {
+                t->burst[b] = random_between(50, 1000);
+                t->io[b] = 1;
+            }
+        }
+    }
+}
+
+static void load(char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[8192];
+    int lineno = 0;
+
+    if (f == 0)
+    {
+        perror(path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), f))
+    {
+        int v[2 * MAXBURSTS + 1], n = 0;
+        char *s = line, *end;
+
+        lineno++;
+        if (line[0] == '#')
+            continue;
+        for (long x = strtol(s, &end, 10); end != s && n < 2 * MAXBURSTS + 1; x = strtol(s, &end, 10))
+        {
+            v[n++] = x;
+            s = end;
+        }
+        if (n == 0)
+            continue;
+        if (n < 3 || n % 2 == 0)
+        {
+            fprintf(stderr, "%s:%d: want arrival priority burst [io burst]...\n", path, lineno);
+            exit(1);
+        }
+        struct sim_task *t = new_task(v[0], v[1], (n - 1) / 2);
+        for (int b = 0; b < t->nbursts; b++)
+        {
+            t->burst[b] = v[2 + 2 * b];
+            if (b + 1 < t->nbursts)
+                t->io[b] = v[3 + 2 * b];
+        }
+    }
+    fclose(f);
+}
+
+static int by_arrival(const void *a, const void *b)
+{
+    const struct sim_task *x = a, *y = b;
+    return x->arrival - y->arrival;
+}
+
+static int by_value(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static double p99(double *sorted, int n)
+{
+    return sorted[(n * 99 + 99) / 100 - 1];
+}
+
+static void report(char *name, struct sim_config *config, struct sim_stats *stats, double wall)
+{
+    double *turnaround = malloc(ntasks * sizeof(double));
+    double *waiting = malloc(ntasks * sizeof(double));
+    double tsum = 0, wsum = 0, xsum = 0, xsq = 0;
+    double second = SIM_TIME_PER_US * 1e6;
+    long migrations = 0, starvations = 0;
+
+    for (int i = 0; i < ntasks; i++)
+    {
+        struct sim_task *t = &tasks[i];
+        turnaround[i] = (t->ttime - t->ctime) / second;
+        waiting[i] = t->retime / second;
+        tsum += turnaround[i];
+        wsum += waiting[i];
+        double x = t->ttime > t->ctime ? (double)t->rutime / (t->ttime - t->ctime) : 1;
+        xsum += x;
+        xsq += x * x;
+        migrations += t->migrations;
+        starvations += t->starvations;
+    }
+    qsort(turnaround, ntasks, sizeof(double), by_value);
+    qsort(waiting, ntasks, sizeof(double), by_value);
+
+    double makespan = stats->end / second;
+    printf("policy=%s harts=%d procs=%d alpha=%d quantum=%d max_wait=%d ipi=%d"
+           " makespan_s=%.3f turnaround_mean_s=%.3f turnaround_p99_s=%.3f"
+           " waiting_mean_s=%.3f waiting_p99_s=%.3f throughput_per_s=%.2f fairness=%.3f"
+           " wakeup_latency_ms=%.3f idle_pct=%.1f migrations=%ld starvations=%ld ticks=%u wall_ms=%.0f\n",
+           name, config->ncpu, ntasks, config->alpha, config->quantum, config->max_wait, config->ipi,
+           makespan, tsum / ntasks, p99(turnaround, ntasks),
+           wsum / ntasks, p99(waiting, ntasks), makespan > 0 ? ntasks / makespan : 0,
+           xsq > 0 ? xsum * xsum / (ntasks * xsq) : 1,
+           stats->wakeups ? stats->wakeup_wait * 1000 / second / stats->wakeups : 0,
+           stats->ticks ? 100.0 * stats->idle / ((double)stats->ticks * SIM_TIMER_INTERVAL * config->ncpu) : 0,
+           migrations, starvations, stats->ticks, wall * 1000);
+    free(turnaround);
+    free(waiting);
+}
+
+int main(int argc, char **argv)
+{
+    struct sim_config config = {4, SCHED_DEFAULT, 50, 5, 50, 1};
+    int counts[3] = {1000, 1000, 1000};
+    int spread = 100;
+    char *only = 0;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i += 2)
+    {
+        if (i + 1 == argc || argv[i][2] != 0)
+            usage();
+        int v = atoi(argv[i + 1]);
+        switch (argv[i][1])
+        {
+        case 'p':
+            only = argv[i + 1];
+            break;
+        case 'C':
+            config.ncpu = v;
+            break;
+        case 'a':
+            config.alpha = v;
+            break;
+        case 'q':
+            config.quantum = v;
+            break;
+        case 'w':
+            config.max_wait = v;
+            break;
+        case 'I':
+            config.ipi = v != 0;
+            break;
+        case 'c':
+            counts[0] = v;
+            break;
+        case 'i':
+            counts[1] = v;
+            break;
+        case 'n':
+            counts[2] = v;
+            break;
+        case 's':
+            spread = v;
+            break;
+        case 'r':
+            seed = v ? v : 1;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (i + 1 < argc || config.ncpu < 1 || config.ncpu > SIM_MAXCPU ||
+        config.alpha < 0 || config.alpha > 100 || config.quantum < 1 || config.max_wait < 1)
+        usage();
+
+    if (i < argc)
+        load(argv[i]);
+    else
+        generate(counts[0], counts[1], counts[2], spread);
+    if (ntasks == 0)
+    {
+        fprintf(stderr, "schedsim: no processes\n");
+        exit(1);
+    }
+    qsort(tasks, ntasks, sizeof(*tasks), by_arrival);
+
+    int found = 0;
+    for (int p = 0; policies[p].name != 0; p++)
+    {
+        if (only == 0 ? policies[p].policy > SCHED_CFSD : strcmp(only, policies[p].name) != 0)
+            continue;
+        found = 1;
+
+        struct sim_stats stats;
+        clock_t start = clock();
+        config.policy = policies[p].policy;
+        if (sim_run(&config, tasks, ntasks, &stats) < 0)
+        {
+            fprintf(stderr, "schedsim: cannot simulate %s\n", policies[p].name);
+            exit(1);
+        }
+        report(policies[p].name, &config, &stats, (double)(clock() - start) / CLOCKS_PER_SEC);
+    }
+    if (!found)
+    {
+        fprintf(stderr, "schedsim: bad policy %s\n", only);
+        exit(1);
+    }
+    return 0;
+}
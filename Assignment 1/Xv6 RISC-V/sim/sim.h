@@ -0,0 +1,51 @@
+// Interface between the simulator driver, schedsim.c, and the
+// simulated kernel, simkernel.c, which compiles kernel/sched.c for
+// the host. It uses host types only, so the driver doesn't need the
+// kernel headers.
+
+// One simulated process: it is forked at tick arrival and then runs
+// burst[0], sleeps io[0] ticks, runs burst[1], ... and exits after
+// its last burst.
+struct sim_task
+{
+    int arrival;  // tick the process is forked
+    int priority; // set_priority() value, 1 to 5
+    int nbursts;
+    int *burst; // CPU bursts, in microseconds
+    int *io;    // ticks asleep after each burst but the last
+
+    // results, in r_time() units.
+    unsigned long ctime;
+    unsigned long ttime;
+    unsigned long retime; // time RUNNABLE
+    unsigned long rutime; // time RUNNING
+    unsigned long stime;  // time SLEEPING
+    int migrations;
+    int starvations;
+};
+
+struct sim_config
+{
+    int ncpu;     // simulated harts
+    int policy;   // SCHED_* policy every process runs under
+    int alpha;    // ALPHA
+    int quantum;  // QUANTUM
+    int max_wait; // MAX_WAIT
+    int ipi;      // whether wakeups may preempt, see resched_cpu()
+};
+
+struct sim_stats
+{
+    unsigned long end;   // r_time() when the last process exited
+    unsigned long idle;  // hart time spent with nothing to run
+    unsigned int ticks;  // timer ticks simulated
+    unsigned long wakeup_wait; // total time from wakeup to run
+    unsigned long wakeups;
+};
+
+#define SIM_MAXCPU 64    // NCPU of the simulated kernel
+#define SIM_MAXPROC 4096 // NPROC of the simulated kernel, live processes at once
+#define SIM_TIME_PER_US 10      // TIME_PER_US
+#define SIM_TIMER_INTERVAL 1000000 // TIMER_INTERVAL
+
+int sim_run(struct sim_config *config, struct sim_task *tasks, int ntasks, struct sim_stats *stats);
@@ -0,0 +1,361 @@
+// The simulated kernel: kernel/sched.c compiled for the host, driven
+// by a tick-by-tick model of scheduler(), sleep(), wakeup() and the
+// timer interrupt.
+//
+// Every simulated hart runs the process sched_pick_next() gives it
+// until the process's CPU burst, its timeslice or the tick ends. At
+// the end of each tick every hart calls sched_tick() for the process
+// it runs, and sched_balance() and sched_age() run when clockintr()
+// would run them. A hart that a wakeup asks to reschedule, see
+// resched_cpu(), gives up its process at once, as it would on the
+// reschedule IPI. Harts are simulated one after the other within a
+// tick. Wakeups happen on tick boundaries, so that is exact but for
+// a process whose timeslice ends within a tick: only its own hart
+// and the harts simulated after it can run it in that tick.
+//
+// ALPHA, QUANTUM and MAX_WAIT are variables here, so one binary can
+// try different values. This file includes no host headers, since
+// kernel/defs.h declares the kernel's own printf() and memset().
+
+#include "sim/sim.h"
+
+#define NCPU SIM_MAXCPU
+#define NPROC SIM_MAXPROC
+#define ALPHA sim_alpha
+#define QUANTUM sim_quantum
+#define MAX_WAIT sim_max_wait
+extern int sim_alpha, sim_quantum, sim_max_wait;
+
+// defs.h declares kernel versions of some C library functions.
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include "kernel/sched.c"
+
+_Static_assert(SIM_TIME_PER_US == TIME_PER_US, "sim.h and param.h disagree");
+_Static_assert(SIM_TIMER_INTERVAL == TIMER_INTERVAL, "sim.h and param.h disagree");
+
+#define WHEEL 1024 // sleep queues, by wake-up tick
+
+int sim_alpha = 50;
+int sim_quantum = 5;
+int sim_max_wait = 50;
+
+struct cpu cpus[NCPU];
+uint ticks;
+
+static struct proc procs[NPROC];
+static int current_cpu; // the hart being simulated, for cpuid()
+static int ipi;         // whether resched_cpu() works
+static uint64 now;      // simulated r_time()
+static uint64 slice_end[NCPU]; // r_time() the timeslice of a hart's process ends, or 0
+
+// simulation state of each proc slot.
+static struct sim_task *task_of[NPROC];
+static int burst_ix[NPROC]; // burst being run
+static uint64 left[NPROC];  // r_time() units left in the burst
+static uint64 since[NPROC]; // r_time() of the last state change
+static int woken[NPROC]; // RUNNABLE after a sleep, for the wakeup latency
+static uint wake_at[NPROC];
+static int wake_next[NPROC];
+static int wheel[WHEEL]; // sleeping slots, linked through wake_next
+static int free_slots[NPROC];
+static int nfree;
+
+// ------------------- KERNEL SHIMS -------------------
+// The simulation is single threaded, so locks are no-ops.
+
+void initlock(struct spinlock *lk, char *name)
+{
+    lk->name = name;
+    lk->locked = 0;
+    lk->cpu = 0;
+}
+
+void acquire(struct spinlock *lk)
+{
+}
+
+void release(struct spinlock *lk)
+{
+}
+
+int cpuid()
+{
+    return current_cpu;
+}
+
+// The reschedule IPI: run() preempts the process cpu runs.
+void resched_cpu(int cpu)
+{
+    cpus[cpu].need_resched = ipi;
+}
+
+// ------------------- PROCESSES -------------------
+
+// set_state() of the simulated kernel, timed with the simulated clock.
+static void sim_set_state(struct proc *p, enum procstate state)
+{
+    int i = p - procs;
+    struct sim_task *task = task_of[i];
+    uint64 delta = now - since[i];
+
+    if (p->state == SLEEPING)
+    {
+        task->stime += delta;
+    }
+    else if (p->state == RUNNABLE)
+    {
+        task->retime += delta;
+    }
+    else if (p->state == RUNNING)
+    {
+        task->rutime += delta;
+        sched_burst_end(p, now - p->run_start);
+    }
+
+    if (state == RUNNING)
+        p->run_start = now;
+    since[i] = now;
+    p->state_tick = ticks;
+    p->state = state;
+}
+
+// make_runnable() on hart cpu.
+static void sim_make_runnable(struct proc *p, int cpu)
+{
+    current_cpu = cpu;
+    sim_set_state(p, RUNNABLE);
+    sched_enqueue(p);
+}
+
+// fork() task as process pid from hart 0.
+// Returns 0 if the process table is full.
+static int spawn(struct sim_task *task, int pid)
+{
+    static const struct perf zero;
+
+    if (nfree == 0)
+        return 0;
+
+    int i = free_slots[--nfree];
+    struct proc *p = &procs[i];
+
+    p->pid = pid;
+    p->state = USED;
+    p->performance = zero;
+    sched_proc_init(p);
+    if (task->priority >= 1 && task->priority <= 5)
+        p->priority = task->priority;
+
+    task_of[i] = task;
+    burst_ix[i] = 0;
+    woken[i] = 0;
+    left[i] = (uint64)task->burst[0] * TIME_PER_US;
+    since[i] = now;
+    task->ctime = now;
+    task->retime = task->rutime = task->stime = 0;
+    sim_make_runnable(p, 0);
+    return 1;
+}
+
+// The CPU burst of p has ended: sleep until its
+// next burst, or exit after its last one.
+// Returns 1 if p exited.
+static int burst_done(struct proc *p)
+{
+    int i = p - procs;
+    struct sim_task *task = task_of[i];
+    int b = burst_ix[i]++;
+
+    if (burst_ix[i] == task->nbursts)
+    {
+        sim_set_state(p, ZOMBIE);
+        task->ttime = now;
+        task->migrations = p->performance.migrations;
+        task->starvations = p->performance.starvations;
+        p->state = UNUSED;
+        free_slots[nfree++] = i;
+        return 1;
+    }
+
+    sim_set_state(p, SLEEPING);
+    wake_at[i] = ticks + (task->io[b] > 0 ? task->io[b] : 1);
+    wake_next[i] = wheel[wake_at[i] % WHEEL];
+    wheel[wake_at[i] % WHEEL] = i;
+    left[i] = (uint64)task->burst[b + 1] * TIME_PER_US;
+    return 0;
+}
+
+// wakeup() the processes whose sleep ends at this tick,
+// on the hart each of them last ran on.
+static void wake_sleepers(void)
+{
+    int *link = &wheel[ticks % WHEEL];
+
+    while (*link >= 0)
+    {
+        int i = *link;
+        if (wake_at[i] != ticks)
+        {
+            link = &wake_next[i];
+            continue;
+        }
+        *link = wake_next[i];
+        woken[i] = 1;
+        sim_make_runnable(&procs[i], procs[i].last_cpu);
+    }
+}
+
+// Run hart cpu from start to end, the length of one tick.
+// Returns the number of processes that exited.
+static int run_hart(int cpu, uint64 start, uint64 end, struct sim_stats *stats)
+{
+    struct cpu *c = &cpus[cpu];
+    uint64 t = start;
+    int exited = 0;
+
+    current_cpu = cpu;
+    while (t < end)
+    {
+        struct proc *p = c->proc;
+
+        if (p == 0)
+        {
+            // scheduler()
+            now = t;
+            p = sched_pick_next();
+            if (p == 0)
+            {
+                stats->idle += end - t;
+                break;
+            }
+            if (p->last_cpu >= 0 && p->last_cpu != cpu)
+                p->performance.migrations++;
+            p->last_cpu = cpu;
+            if (ticks - p->state_tick >= MAX_WAIT)
+                p->performance.starvations++;
+            c->need_resched = 0;
+            if (woken[p - procs])
+            {
+                stats->wakeup_wait += t - since[p - procs];
+                stats->wakeups++;
+                woken[p - procs] = 0;
+            }
+            sim_set_state(p, RUNNING);
+            uint64 slice = sched_timeslice(p);
+            slice_end[cpu] = slice != 0 ? t + slice : 0;
+            c->proc = p;
+        }
+
+        int i = p - procs;
+        uint64 run = left[i] < end - t ? left[i] : end - t;
+        if (slice_end[cpu] != 0 && slice_end[cpu] - t < run)
+            run = slice_end[cpu] - t;
+        t += run;
+        left[i] -= run;
+        if (left[i] == 0)
+        {
+            now = t;
+            exited += burst_done(p);
+            c->proc = 0;
+        }
+        else if (t == slice_end[cpu])
+        {
+            // the timeslice has ended: yield()
+            now = t;
+            c->proc = 0;
+            sim_make_runnable(p, cpu);
+        }
+    }
+    return exited;
+}
+
+// Run tasks, sorted by arrival, to completion under config.
+// Returns -1 if config is not one the simulated kernel supports.
+int sim_run(struct sim_config *config, struct sim_task *tasks, int ntasks, struct sim_stats *stats)
+{
+    int next = 0, done = 0;
+
+    if (config->ncpu < 1 || config->ncpu > NCPU)
+        return -1;
+    schedinit();
+    if (sched_set_default(config->policy) < 0)
+        return -1;
+    sim_alpha = config->alpha;
+    sim_quantum = config->quantum;
+    sim_max_wait = config->max_wait;
+    ipi = config->ipi;
+
+    nfree = 0;
+    for (int i = NPROC - 1; i >= 0; i--)
+    {
+        procs[i].state = UNUSED;
+        free_slots[nfree++] = i;
+    }
+    for (int i = 0; i < WHEEL; i++)
+        wheel[i] = -1;
+    for (int i = 0; i < NCPU; i++)
+    {
+        cpus[i].proc = 0;
+        cpus[i].start = i < config->ncpu;
+        cpus[i].need_resched = 0;
+    }
+    ticks = 0;
+    now = 0;
+    stats->idle = 0;
+    stats->wakeup_wait = 0;
+    stats->wakeups = 0;
+
+    while (done < ntasks)
+    {
+        uint64 start = (uint64)ticks * TIMER_INTERVAL;
+        uint64 end = start + TIMER_INTERVAL;
+
+        now = start;
+        while (next < ntasks && tasks[next].arrival <= ticks && spawn(&tasks[next], next + 1))
+            next++;
+        wake_sleepers();
+
+        // the harts that these made reschedule give up their process.
+        for (int cpu = 0; cpu < config->ncpu; cpu++)
+        {
+            struct proc *p = cpus[cpu].proc;
+            if (cpus[cpu].need_resched && p != 0)
+            {
+                // yield()
+                cpus[cpu].proc = 0;
+                sim_make_runnable(p, cpu);
+            }
+            cpus[cpu].need_resched = 0;
+        }
+
+        for (int cpu = 0; cpu < config->ncpu; cpu++)
+            done += run_hart(cpu, start, end, stats);
+
+        // the timer interrupt.
+        now = end;
+        ticks++;
+        for (int cpu = 0; cpu < config->ncpu; cpu++)
+        {
+            struct proc *p = cpus[cpu].proc;
+            current_cpu = cpu;
+            if (p != 0 && sched_tick(p))
+            {
+                // yield()
+                cpus[cpu].proc = 0;
+                sim_make_runnable(p, cpu);
+            }
+        }
+        current_cpu = 0;
+        if (ticks % BALANCE_INTERVAL == 0)
+            sched_balance();
+        if (ticks % AGE_INTERVAL == 0)
+            sched_age();
+    }
+
+    stats->ticks = ticks;
+    stats->end = 0;
+    for (int i = 0; i < ntasks; i++)
+        if (tasks[i].ttime > stats->end)
+            stats->end = tasks[i].ttime;
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "kernel/types.h"
+#include "kernel/sched.h"
+#include "user/user.h"
+
+// Checks set_deadline() and the EDF counters of wait_stat().
+// Parameters that can't be met and task sets that need more than
+// one CPU must be refused. A periodic task that asks for more time
+// than it uses must meet every deadline, and a task that spins
+// through its budget must overrun it and miss deadlines.
+// Run it on a single hart, make qemu CPUS=1, with nothing else
+// running under EDF.
+
+#define PERIOD 10 // ticks
+#define JOBS 20   // jobs of the periodic task
+#define SPIN 100  // ticks the overloaded task spins for
+
+int failed = 0;
+
+void expect(char *what, int got, int want)
+{
+    if (got != want)
+    {
+        printf("edftest: %s: got %d, want %d\n", what, got, want);
+        failed = 1;
+    }
+}
+
+// Run fn in a child and return the EDF counters it leaves behind.
+void run_child(void (*fn)(void), struct perf *performance)
+{
+    int status, pid;
+
+    if ((pid = fork()) == 0)
+    {
+        fn();
+        exit(0);
+    }
+    if (pid < 0)
+    {
+        printf("edftest: fork failed\n");
+        exit(1);
+    }
+    if (wait_stat(&status, performance) != pid || status != 0)
+    {
+        printf("edftest: child failed\n");
+        exit(1);
+    }
+}
+
+void admission(void)
+{
+    int ready[2], hold[2], pid;
+    char c;
+
+    expect("runtime > deadline", set_deadline(4, PERIOD, 3), -1);
+    expect("deadline > period", set_deadline(2, PERIOD, PERIOD + 1), -1);
+    expect("negative runtime", set_deadline(-1, PERIOD, 0), -1);
+
+    // a child reserves 6/10 of the CPU and sleeps, keeping it,
+    // until the parent closes hold[1].
+    if (pipe(ready) < 0 || pipe(hold) < 0)
+    {
+        printf("edftest: pipe failed\n");
+        exit(1);
+    }
+    if ((pid = fork()) == 0)
+    {
+        close(ready[0]);
+        close(hold[1]);
+        c = set_deadline(6, PERIOD, 0) == 0;
+        write(ready[1], &c, 1);
+        read(hold[0], &c, 1);
+        exit(0);
+    }
+    if (pid < 0)
+    {
+        printf("edftest: fork failed\n");
+        exit(1);
+    }
+    close(ready[1]);
+    close(hold[0]);
+    if (read(ready[0], &c, 1) != 1 || !c)
+    {
+        printf("edftest: child could not reserve 6/10\n");
+        failed = 1;
+    }
+
+    expect("utilization above 1", set_deadline(5, PERIOD, 0), -1);
+    expect("utilization of exactly 1", set_deadline(4, PERIOD, 0), 0);
+    expect("leaving EDF", set_deadline(0, 0, 0), 0);
+
+    close(hold[1]);
+    wait(0);
+    close(ready[0]);
+
+    // the child gave its bandwidth back when it exited.
+    expect("whole CPU after exit", set_deadline(PERIOD, PERIOD, 0), 0);
+    set_deadline(0, 0, 0);
+}
+
+// Each job spins for about one tick of its budget of two, then
+// sleeps past the end of its period, so its next job starts when
+// it wakes up.
+void feasible(void)
+{
+    if (set_deadline(2, PERIOD, PERIOD / 2) < 0)
+        exit(1);
+    for (int i = 0; i < JOBS; i++)
+    {
+        int start = uptime();
+        while (uptime() == start)
+            ;
+        sleep(PERIOD);
+    }
+}
+
+// Wants the CPU all the time but may use only two ticks of every
+// period, so every job overruns its budget and misses its deadline.
+void overloaded(void)
+{
+    if (set_deadline(2, PERIOD, 0) < 0)
+        exit(1);
+    int end = uptime() + SPIN;
+    while (uptime() < end)
+        ;
+}
+
+int main(int argc, char **argv)
+{
+    struct perf performance;
+
+    admission();
+
+    run_child(feasible, &performance);
+    printf("feasible: %d misses, %d overruns\n", performance.deadline_misses, performance.overruns);
+    expect("feasible task misses", performance.deadline_misses, 0);
+    expect("feasible task overruns", performance.overruns, 0);
+
+    run_child(overloaded, &performance);
+    printf("overloaded: %d misses, %d overruns\n", performance.deadline_misses, performance.overruns);
+    if (performance.deadline_misses == 0 || performance.overruns == 0)
+    {
+        printf("edftest: overloaded task reported no misses or overruns\n");
+        failed = 1;
+    }
+
+    printf(failed ? "edftest: FAILED\n" : "edftest: OK\n");
+    exit(failed);
+}
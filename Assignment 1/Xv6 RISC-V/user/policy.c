@@ -0,0 +1,51 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/sched.h"
+#include "user/user.h"
+
+// policy NAME        set the system default scheduling policy
+// policy NAME pid... set the policy of the given processes
+// NAME is DEFAULT, FCFS, SRT, CFSD, MLFQ, STRIDE or SYSTEM (follow the default).
+// EDF is not a NAME, a process enters it with set_deadline().
+
+char *names[NSCHED] = {
+  [SCHED_DEFAULT] "DEFAULT",
+  [SCHED_FCFS] "FCFS",
+  [SCHED_SRT] "SRT",
+  [SCHED_CFSD] "CFSD",
+  [SCHED_MLFQ] "MLFQ",
+  [SCHED_STRIDE] "STRIDE",
+};
+
+int
+main(int argc, char **argv)
+{
+  int i, policy = -2;
+
+  if(argc < 2){
+    fprintf(2, "usage: policy DEFAULT|FCFS|SRT|CFSD|MLFQ|STRIDE|SYSTEM [pid...]\n");
+    exit(1);
+  }
+  for(i = 0; i < NSCHED; i++)
+    if(names[i] && strcmp(argv[1], names[i]) == 0)
+      policy = i;
+  if(strcmp(argv[1], "SYSTEM") == 0)
+    policy = SCHED_SYSTEM;
+  if(policy == -2 || (policy == SCHED_SYSTEM && argc == 2)){
+    fprintf(2, "policy: bad policy %s\n", argv[1]);
+    exit(1);
+  }
+
+  if(argc == 2){
+    if(set_policy(policy, SET_POLICY_SYSTEM) < 0){
+      fprintf(2, "policy: cannot set system policy\n");
+      exit(1);
+    }
+    exit(0);
+  }
+  for(i = 2; i < argc; i++){
+    if(set_policy(policy, atoi(argv[i])) < 0)
+      fprintf(2, "policy: no process %s\n", argv[i]);
+  }
+  exit(0);
+}
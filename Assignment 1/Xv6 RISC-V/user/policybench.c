@@ -0,0 +1,241 @@
+#include "kernel/param.h"
+#include "kernel/types.h"
+#include "kernel/sched.h"
+#include "user/user.h"
+
+//
+// Scheduling policy benchmark.
+//   policybench [-p POLICY] [-c n] [-i n] [-n n] [-w m]
+// runs a mix of -c CPU bound, -i I/O bound and -n interactive children
+// (default 4 of each) under POLICY, or under DEFAULT, FCFS, SRT and CFSD
+// one after the other when -p is not given. CPU bound children spin for
+// -w million iterations (default 20), I/O bound children alternate
+// short bursts with sleep() and interactive children wake up every tick
+// for a tiny burst.
+//
+// For every policy it prints one line per kind of child and one for all
+// of them, as key=value pairs so runs can be compared with a script:
+//   policy=SRT class=cpu n=4 turnaround_mean=.. turnaround_p99=..
+//   waiting_mean=.. waiting_p99=.. throughput_milli=.. fairness_milli=..
+// Times are in ticks, from the children's wait_stat() counters:
+// turnaround is ttime - ctime, waiting is retime. throughput_milli is
+// children finished per 1000 ticks, fairness_milli is Jain's index of
+// rutime / turnaround scaled to 1000, 1000 being perfectly fair.
+//
+
+#define MAXCHILD 48 // children of one run
+#define IO_ROUNDS 10
+#define IO_SLEEP 2
+#define INTERACTIVE_ROUNDS 50
+
+#define CPU 0
+#define IO 1
+#define INTERACTIVE 2
+#define NCLASS 3
+
+char *classes[NCLASS] = {"cpu", "io", "interactive"};
+
+struct
+{
+    char *name;
+    int policy;
+} policies[] = {
+    {"DEFAULT", SCHED_DEFAULT},
+    {"FCFS", SCHED_FCFS},
+    {"SRT", SCHED_SRT},
+    {"CFSD", SCHED_CFSD},
+    {"MLFQ", SCHED_MLFQ},
+    {"STRIDE", SCHED_STRIDE},
+    {0, 0},
+};
+
+int counts[NCLASS] = {4, 4, 4};
+int spin = 20000000;
+
+struct result
+{
+    int class;
+    struct perf perf;
+} results[MAXCHILD];
+
+void burn(int n)
+{
+    for (volatile int i = 0; i < n; i++)
+        ;
+}
+
+void child(int class)
+{
+    if (class == CPU)
+    {
+        burn(spin);
+    }
+    else if (class == IO)
+    {
+        for (int i = 0; i < IO_ROUNDS; i++)
+        {
+            burn(spin / 100);
+            sleep(IO_SLEEP);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < INTERACTIVE_ROUNDS; i++)
+        {
+            burn(spin / 2000);
+            sleep(1);
+        }
+    }
+    exit(0);
+}
+
+void sort(int *a, int n)
+{
+    for (int i = 1; i < n; i++)
+    {
+        int v = a[i], j;
+        for (j = i; j > 0 && a[j - 1] > v; j--)
+            a[j] = a[j - 1];
+        a[j] = v;
+    }
+}
+
+// the smallest value that at least 99% of the n sorted values don't exceed.
+int p99(int *sorted, int n)
+{
+    return sorted[(n * 99 + 99) / 100 - 1];
+}
+
+// print the statistics of the results of class, or of all of them if class < 0.
+void report(char *policy, int class, int n)
+{
+    int turnaround[MAXCHILD], waiting[MAXCHILD];
+    int m = 0, start = 0, end = 0;
+    uint64 tsum = 0, wsum = 0, xsum = 0, xsq = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        struct perf *pf = &results[i].perf;
+        if (class >= 0 && results[i].class != class)
+            continue;
+        turnaround[m] = pf->ttime - pf->ctime;
+        waiting[m] = pf->retime;
+        tsum += turnaround[m];
+        wsum += waiting[m];
+        uint64 x = turnaround[m] > 0 ? (uint64)pf->rutime * 1000 / turnaround[m] : 1000;
+        xsum += x;
+        xsq += x * x;
+        if (m == 0 || pf->ctime < start)
+            start = pf->ctime;
+        if (m == 0 || pf->ttime > end)
+            end = pf->ttime;
+        m++;
+    }
+    if (m == 0)
+        return;
+    sort(turnaround, m);
+    sort(waiting, m);
+
+    printf("policy=%s class=%s n=%d turnaround_mean=%d turnaround_p99=%d waiting_mean=%d waiting_p99=%d throughput_milli=%d fairness_milli=%d\n",
+           policy, class < 0 ? "all" : classes[class], m,
+           (int)(tsum / m), p99(turnaround, m), (int)(wsum / m), p99(waiting, m),
+           end > start ? m * 1000 / (end - start) : 0,
+           xsq > 0 ? (int)(xsum * xsum * 1000 / (m * xsq)) : 1000);
+}
+
+// run one mix of children under policy and report on them.
+void run(char *name, int policy)
+{
+    int pids[MAXCHILD];
+    int n = 0;
+
+    // children inherit the policy of the process that forks them.
+    if (set_policy(policy, getpid()) < 0)
+    {
+        fprintf(2, "policybench: cannot set policy %s\n", name);
+        exit(1);
+    }
+
+    // start the kinds interleaved, so no kind gets a head start.
+    for (int round = 0; n < MAXCHILD; round++)
+    {
+        int forked = 0;
+        for (int class = 0; class < NCLASS && n < MAXCHILD; class++)
+        {
+            if (round >= counts[class])
+                continue;
+            int pid = fork();
+            if (pid < 0)
+            {
+                fprintf(2, "policybench: fork failed\n");
+                exit(1);
+            }
+            if (pid == 0)
+                child(class);
+            pids[n] = pid;
+            results[n++].class = class;
+            forked = 1;
+        }
+        if (!forked)
+            break;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        int status;
+        struct perf pf;
+        int pid = wait_stat(&status, &pf);
+        for (int j = 0; j < n; j++)
+            if (pids[j] == pid)
+                results[j].perf = pf;
+    }
+
+    for (int class = 0; class < NCLASS; class++)
+        report(name, class, n);
+    report(name, -1, n);
+
+    set_policy(SCHED_SYSTEM, getpid());
+}
+
+int main(int argc, char **argv)
+{
+    char *only = 0;
+    int i;
+
+    for (i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "-p") == 0)
+            only = argv[i + 1];
+        else if (strcmp(argv[i], "-c") == 0)
+            counts[CPU] = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-i") == 0)
+            counts[IO] = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-n") == 0)
+            counts[INTERACTIVE] = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-w") == 0)
+            spin = atoi(argv[i + 1]) * 1000000;
+        else
+            break;
+    }
+    if (i != argc || spin <= 0 || counts[CPU] + counts[IO] + counts[INTERACTIVE] > MAXCHILD)
+    {
+        fprintf(2, "usage: policybench [-p POLICY] [-c n] [-i n] [-n n] [-w m], at most %d children\n", MAXCHILD);
+        exit(1);
+    }
+
+    int found = 0;
+    for (i = 0; policies[i].name != 0; i++)
+    {
+        // without -p, compare the policies that wait_stat() was made for.
+        if (only == 0 ? policies[i].policy > SCHED_CFSD : strcmp(only, policies[i].name) != 0)
+            continue;
+        run(policies[i].name, policies[i].policy);
+        found = 1;
+    }
+    if (!found)
+    {
+        fprintf(2, "policybench: bad policy %s\n", only);
+        exit(1);
+    }
+    exit(0);
+}
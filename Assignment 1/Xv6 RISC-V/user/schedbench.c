@@ -0,0 +1,427 @@
+#include "kernel/param.h"
+#include "kernel/types.h"
+#include "kernel/sched.h"
+#include "user/user.h"
+
+//
+// Scheduler micro-benchmarks.  schedbench without arguments runs them all
+// and schedbench <name> runs <name> only.  Run the same benchmark on kernels
+// built with different SCHEDFLAG / NPROC / CPUS values to compare them, e.g.
+//   make clean && make qemu SCHEDFLAG=SRT NPROC=256 CPUS=1
+//   make clean && make qemu SCHEDFLAG=FCFS CPUS=8
+//   make clean && make qemu SCHEDFLAG=CFSD CPUS=4
+//
+
+#define ROUNDS 2000   // ping-pong round trips per measurement
+#define WORKERS 16    // concurrent workers in contend
+#define FORKS 100     // fork/exit/wait cycles per worker in contend
+#define SPINNERS 12   // CPU bound children in balance
+#define SPIN 20000000 // loop iterations of every spinner
+#define WAKEUPS 200   // ping-pong round trips in wakeup
+#define HOGS 8        // CPU bound children of the tenant in cpugroup
+#define GROUP_QUOTA 2   // ticks of CPU time the tenant gets per period
+#define GROUP_PERIOD 10 // ticks
+
+// fork n children that block on hold[0] until the parent closes hold[1],
+// so they occupy proc slots without ever becoming RUNNABLE.
+int spawn_sleepers(int n, int hold[2])
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        int pid = fork();
+        if (pid < 0)
+            break;
+        if (pid == 0)
+        {
+            char c;
+            close(hold[1]);
+            read(hold[0], &c, 1);
+            exit(0);
+        }
+    }
+    return i;
+}
+
+void reap_sleepers(int n, int hold[2])
+{
+    close(hold[1]);
+    close(hold[0]);
+    for (int i = 0; i < n; i++)
+        wait(0);
+}
+
+// bounce one byte between two processes rounds times.
+// every round trip costs two scheduling decisions on a single hart.
+// returns the number of ticks it took.
+int pingpong(int rounds)
+{
+    int ping[2], pong[2];
+    char c = 0;
+
+    if (pipe(ping) < 0 || pipe(pong) < 0)
+    {
+        printf("schedbench: pipe failed\n");
+        exit(1);
+    }
+
+    int pid = fork();
+    if (pid < 0)
+    {
+        printf("schedbench: fork failed\n");
+        exit(1);
+    }
+    if (pid == 0)
+    {
+        for (int i = 0; i < rounds; i++)
+        {
+            read(ping[0], &c, 1);
+            write(pong[1], &c, 1);
+        }
+        exit(0);
+    }
+
+    int start = uptime();
+    for (int i = 0; i < rounds; i++)
+    {
+        write(ping[1], &c, 1);
+        read(pong[0], &c, 1);
+    }
+    int elapsed = uptime() - start;
+
+    wait(0);
+    close(ping[0]);
+    close(ping[1]);
+    close(pong[0]);
+    close(pong[1]);
+    return elapsed;
+}
+
+// scheduling decision latency as the proc table fills up.
+// a policy that scans proc[] pays for every slot on each decision,
+// a run queue only pays for the processes that are actually RUNNABLE.
+void decide(char *s)
+{
+    int populations[] = {0, NPROC / 4, NPROC / 2, NPROC - 8};
+
+    for (int i = 0; i < sizeof(populations) / sizeof(populations[0]); i++)
+    {
+        int hold[2];
+        if (pipe(hold) < 0)
+        {
+            printf("%s: pipe failed\n", s);
+            exit(1);
+        }
+        int n = spawn_sleepers(populations[i], hold);
+        int ticks = pingpong(ROUNDS);
+        reap_sleepers(n, hold);
+
+        printf("%s: nproc %d sleepers %d switches %d ticks %d\n", s, NPROC, n, 2 * ROUNDS, ticks);
+    }
+}
+
+// run-queue lock contention: many workers that fork, exit and wait at
+// once, so every hart keeps enqueueing and dequeueing. run it with
+// CPUS=8 to see whether the run queues serialize the harts.
+void contend(char *s)
+{
+    int start = uptime();
+
+    for (int i = 0; i < WORKERS; i++)
+    {
+        int pid = fork();
+        if (pid < 0)
+        {
+            printf("%s: fork failed\n", s);
+            exit(1);
+        }
+        if (pid == 0)
+        {
+            for (int j = 0; j < FORKS; j++)
+            {
+                int cpid = fork();
+                if (cpid < 0)
+                {
+                    printf("%s: fork failed\n", s);
+                    exit(1);
+                }
+                if (cpid == 0)
+                    exit(0);
+                wait(0);
+            }
+            exit(0);
+        }
+    }
+    for (int i = 0; i < WORKERS; i++)
+        wait(0);
+
+    printf("%s: workers %d forks %d ticks %d\n", s, WORKERS, WORKERS * FORKS, uptime() - start);
+}
+
+// load balancing: SPINNERS CPU bound children, all forked from this
+// hart, so they start out on its run queue. prints how busy each hart
+// was and how much the completion times of the children vary; with a
+// working balancer every hart is busy and the times are close.
+void balance(char *s)
+{
+    struct cpustat before[NCPU], after[NCPU];
+    int done[SPINNERS];
+    int migrations = 0;
+
+    cpustat(before, NCPU);
+    for (int i = 0; i < SPINNERS; i++)
+    {
+        int pid = fork();
+        if (pid < 0)
+        {
+            printf("%s: fork failed\n", s);
+            exit(1);
+        }
+        if (pid == 0)
+        {
+            for (volatile int j = 0; j < SPIN; j++)
+                ;
+            exit(0);
+        }
+    }
+    for (int i = 0; i < SPINNERS; i++)
+    {
+        int status;
+        struct perf performance;
+        wait_stat(&status, &performance);
+        done[i] = performance.ttime - performance.ctime;
+        migrations += performance.migrations;
+    }
+    cpustat(after, NCPU);
+
+    for (int i = 0; i < NCPU; i++)
+    {
+        uint64 total = after[i].total - before[i].total;
+        uint64 idle = after[i].idle - before[i].idle;
+        if (after[i].total == 0 || total == 0)
+            continue;
+        printf("%s: hart %d busy %d%%\n", s, i, (int)((total - idle) * 100 / total));
+    }
+
+    int mean = 0, variance = 0;
+    for (int i = 0; i < SPINNERS; i++)
+        mean += done[i];
+    mean /= SPINNERS;
+    for (int i = 0; i < SPINNERS; i++)
+        variance += (done[i] - mean) * (done[i] - mean);
+    variance /= SPINNERS;
+    printf("%s: children %d mean ticks %d variance %d migrations %d\n", s, SPINNERS, mean, variance, migrations);
+}
+
+// wakeup-to-run latency: a ping-pong under SRT while CPU bound
+// spinners keep every hart busy. the ping-pong processes have short
+// bursts, so each wakeup should preempt a spinner at once instead of
+// waiting for its quantum to end. prints the time per wakeup; compare
+// it between kernels, or look at the latencies with schedtrace.
+void wakeup(char *s)
+{
+    struct cpustat cs[NCPU];
+    int pids[2 * NCPU];
+    int n = 0;
+
+    cpustat(cs, NCPU);
+    for (int i = 0; i < NCPU; i++)
+        if (cs[i].total != 0)
+            n += 2;
+
+    // children inherit the policy of the process that forks them.
+    if (set_policy(SCHED_SRT, getpid()) < 0)
+    {
+        printf("%s: cannot set policy SRT\n", s);
+        exit(1);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        pids[i] = fork();
+        if (pids[i] < 0)
+        {
+            printf("%s: fork failed\n", s);
+            exit(1);
+        }
+        if (pids[i] == 0)
+        {
+            for (;;)
+                ;
+        }
+    }
+
+    int ticks = pingpong(WAKEUPS);
+
+    for (int i = 0; i < n; i++)
+    {
+        kill(pids[i]);
+        wait(0);
+    }
+    set_policy(SCHED_SYSTEM, getpid());
+
+    printf("%s: spinners %d wakeups %d ticks %d us per wakeup %d\n", s, n, 2 * WAKEUPS, ticks,
+           ticks * (TIMER_INTERVAL / TIME_PER_US) / (2 * WAKEUPS));
+}
+
+// timeslices: a ping-pong under DEFAULT, which doesn't preempt on
+// wakeup, shares one hart with a CPU bound spinner, so every wakeup
+// waits for the spinner's timeslice to end. prints the time per
+// wakeup with the spinner's timeslice cut to 1ms and with the one
+// its priority gives it.
+void timeslice(char *s)
+{
+    int slices[] = {1000, 0};
+    uint64 mask;
+
+    sched_getaffinity(0, &mask);
+    if (set_policy(SCHED_DEFAULT, getpid()) < 0 || sched_setaffinity(0, 1) < 0)
+    {
+        printf("%s: cannot set policy or affinity\n", s);
+        exit(1);
+    }
+    for (int i = 0; i < sizeof(slices) / sizeof(slices[0]); i++)
+    {
+        int pid = fork();
+        if (pid < 0)
+        {
+            printf("%s: fork failed\n", s);
+            exit(1);
+        }
+        if (pid == 0)
+        {
+            for (;;)
+                ;
+        }
+        sched_settimeslice(pid, slices[i]);
+        int slice = sched_gettimeslice(pid);
+
+        int ticks = pingpong(WAKEUPS);
+
+        kill(pid);
+        wait(0);
+        printf("%s: spinner timeslice us %d wakeups %d ticks %d us per wakeup %d\n", s, slice, 2 * WAKEUPS,
+               ticks, ticks * (TIMER_INTERVAL / TIME_PER_US) / (2 * WAKEUPS));
+    }
+    sched_setaffinity(0, mask);
+    set_policy(SCHED_SYSTEM, getpid());
+}
+
+// CPU bandwidth groups: a tenant forks HOGS CPU bound children
+// while another process runs a spinner of the same length. prints
+// how long the spinner waited, first with the tenant unlimited, then
+// with it in a group capped at GROUP_QUOTA ticks per GROUP_PERIOD,
+// along with the group's counters.
+void cpugroup(char *s)
+{
+    for (int limit = 0; limit < 2; limit++)
+    {
+        int ready[2];
+        int gid = 0;
+
+        if (pipe(ready) < 0)
+        {
+            printf("%s: pipe failed\n", s);
+            exit(1);
+        }
+        int tenant = fork();
+        if (tenant < 0)
+        {
+            printf("%s: fork failed\n", s);
+            exit(1);
+        }
+        if (tenant == 0)
+        {
+            if (limit)
+                gid = cpugroup_create(GROUP_QUOTA, GROUP_PERIOD);
+            write(ready[1], &gid, sizeof(gid));
+            for (int i = 0; i < HOGS; i++)
+            {
+                if (fork() == 0)
+                {
+                    for (volatile int j = 0; j < SPIN; j++)
+                        ;
+                    exit(0);
+                }
+            }
+            for (int i = 0; i < HOGS; i++)
+                wait(0);
+            exit(0);
+        }
+        read(ready[0], &gid, sizeof(gid));
+        close(ready[0]);
+        close(ready[1]);
+        if (limit && gid < 0)
+        {
+            printf("%s: cpugroup_create failed\n", s);
+            exit(1);
+        }
+
+        int victim = fork();
+        if (victim < 0)
+        {
+            printf("%s: fork failed\n", s);
+            exit(1);
+        }
+        if (victim == 0)
+        {
+            for (volatile int j = 0; j < SPIN; j++)
+                ;
+            exit(0);
+        }
+
+        int status, pid;
+        struct perf performance;
+        while ((pid = wait_stat(&status, &performance)) != victim && pid >= 0)
+            ;
+        printf("%s: tenant %s spinner turnaround %d retime %d\n", s, limit ? "capped" : "unlimited",
+               performance.ttime - performance.ctime, performance.retime);
+
+        struct cpugroup_stat st;
+        if (limit && cpugroup_stat(gid, &st) == 0)
+        {
+            printf("%s: group %d quota %d period %d procs %d usage ticks %d periods %d throttled %d throttled ticks %d\n",
+                   s, gid, st.quota, st.period, st.nprocs, (int)(st.usage / TIMER_INTERVAL), (int)st.periods,
+                   (int)st.nthrottled, (int)st.throttled_time);
+        }
+        wait(0);
+    }
+}
+
+struct bench
+{
+    void (*f)(char *);
+    char *s;
+} benches[] = {
+    {decide, "decide"},
+    {contend, "contend"},
+    {balance, "balance"},
+    {wakeup, "wakeup"},
+    {timeslice, "timeslice"},
+    {cpugroup, "cpugroup"},
+    {0, 0},
+};
+
+int main(int argc, char **argv)
+{
+    char *justone = 0;
+
+    if (argc == 2)
+    {
+        justone = argv[1];
+    }
+    else if (argc > 2)
+    {
+        printf("Usage: schedbench [benchname]\n");
+        exit(1);
+    }
+
+    for (struct bench *b = benches; b->s != 0; b++)
+    {
+        if (justone == 0 || strcmp(b->s, justone) == 0)
+        {
+            b->f(b->s);
+        }
+    }
+    exit(0);
+}
@@ -0,0 +1,259 @@
+#include "kernel/param.h"
+#include "kernel/types.h"
+#include "kernel/sched.h"
+#include "user/user.h"
+
+//
+// Trace the scheduler while a command runs.
+//   schedtrace [-t] command [args...]
+// prints, for every process that ran, how often it was dispatched,
+// preempted, put to sleep, woken up and migrated, with its run-queue
+// latency, followed by a histogram of the run-queue latencies of all
+// of them. -t also prints every event as it happened.
+//
+// A collector child drains the kernel's trace rings once a tick while
+// the command runs, so they don't fill up and drop events.
+//
+
+#define CHUNK 64    // events drained per sched_trace_read()
+#define NPSTAT 128  // processes the summary can tell apart
+#define NBUCKET 24  // latency histogram buckets, powers of two in microseconds
+
+char *events[SCHED_NEV] = {
+    [SCHED_EV_NEW] "new",
+    [SCHED_EV_DISPATCH] "dispatch",
+    [SCHED_EV_PREEMPT] "preempt",
+    [SCHED_EV_SLEEP] "sleep",
+    [SCHED_EV_WAKEUP] "wakeup",
+    [SCHED_EV_MIGRATE] "migrate",
+    [SCHED_EV_EXIT] "exit",
+};
+
+// procstate names, in the order of kernel/proc.h.
+char *states[] = {"unused", "used", "sleep", "runble", "run", "zombie"};
+
+char *policies[NSCHED] = {
+    [SCHED_DEFAULT] "DEFAULT",
+    [SCHED_FCFS] "FCFS",
+    [SCHED_SRT] "SRT",
+    [SCHED_CFSD] "CFSD",
+    [SCHED_MLFQ] "MLFQ",
+    [SCHED_STRIDE] "STRIDE",
+    [SCHED_EDF] "EDF",
+};
+
+struct pstat
+{
+    int pid;
+    int count[SCHED_NEV]; // events of each type
+    uint64 ready;         // time the process last became RUNNABLE, 0 if it isn't
+    uint64 latency;       // total time from RUNNABLE to RUNNING
+    uint64 max_latency;
+    int waits;            // dispatches that latency covers
+    int metric;           // policy metric at the last event
+    int policy;
+};
+
+struct sched_event *ev;
+int nev;
+struct pstat pstats[NPSTAT];
+int npstat;
+int hist[NBUCKET];
+
+// drain the trace rings until tracing stops, skipping the events of
+// the tracer processes themselves.
+void collect(int skip1, int skip2)
+{
+    int cap = 0;
+
+    ev = (struct sched_event *)sbrk(0);
+    for (;;)
+    {
+        if (nev + CHUNK > cap)
+        {
+            if (sbrk(CHUNK * sizeof(struct sched_event)) == (char *)-1)
+            {
+                fprintf(2, "schedtrace: out of memory after %d events\n", nev);
+                sched_trace(0);
+                return;
+            }
+            cap += CHUNK;
+        }
+        int n = sched_trace_read(ev + nev, CHUNK);
+        if (n < 0)
+            break;
+        if (n == 0)
+        {
+            sleep(1);
+            continue;
+        }
+        int kept = nev;
+        for (int i = nev; i < nev + n; i++)
+            if (ev[i].pid != skip1 && ev[i].pid != skip2)
+                ev[kept++] = ev[i];
+        nev = kept;
+    }
+}
+
+// the rings are drained one hart after the other, so
+// put the events of all harts back in time order.
+void sort_events(void)
+{
+    for (int gap = nev / 2; gap > 0; gap /= 2)
+    {
+        for (int i = gap; i < nev; i++)
+        {
+            struct sched_event e = ev[i];
+            int j;
+            for (j = i; j >= gap && ev[j - gap].time > e.time; j -= gap)
+                ev[j] = ev[j - gap];
+            ev[j] = e;
+        }
+    }
+}
+
+struct pstat *pstat_of(int pid)
+{
+    for (int i = 0; i < npstat; i++)
+        if (pstats[i].pid == pid)
+            return &pstats[i];
+    if (npstat == NPSTAT)
+        return 0;
+    struct pstat *s = &pstats[npstat++];
+    memset(s, 0, sizeof(*s));
+    s->pid = pid;
+    return s;
+}
+
+int bucket_of(uint64 us)
+{
+    int b = 0;
+    while (us > 0 && b < NBUCKET - 1)
+    {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void analyze(int timeline)
+{
+    uint64 t0 = nev > 0 ? ev[0].time : 0;
+
+    for (int i = 0; i < nev; i++)
+    {
+        struct sched_event *e = &ev[i];
+
+        if (timeline)
+        {
+            printf("%l us hart %d pid %d %s %s->%s metric %d\n",
+                   (e->time - t0) / TIME_PER_US, e->cpu, e->pid, events[e->type],
+                   states[e->old_state], states[e->new_state], e->metric);
+        }
+
+        struct pstat *s = pstat_of(e->pid);
+        if (s == 0)
+            continue;
+        s->count[e->type]++;
+        s->metric = e->metric;
+        s->policy = e->policy;
+        if (e->type == SCHED_EV_NEW || e->type == SCHED_EV_WAKEUP || e->type == SCHED_EV_PREEMPT)
+        {
+            s->ready = e->time;
+        }
+        else if (e->type == SCHED_EV_DISPATCH && s->ready != 0)
+        {
+            uint64 lat = (e->time - s->ready) / TIME_PER_US;
+            s->latency += lat;
+            if (lat > s->max_latency)
+                s->max_latency = lat;
+            s->waits++;
+            hist[bucket_of(lat)]++;
+            s->ready = 0;
+        }
+    }
+
+    printf("pid policy dispatch preempt sleep wakeup migrate mean_lat_us max_lat_us metric\n");
+    for (int i = 0; i < npstat; i++)
+    {
+        struct pstat *s = &pstats[i];
+        printf("%d %s %d %d %d %d %d %l %l %d\n", s->pid, policies[s->policy],
+               s->count[SCHED_EV_DISPATCH], s->count[SCHED_EV_PREEMPT],
+               s->count[SCHED_EV_SLEEP], s->count[SCHED_EV_WAKEUP],
+               s->count[SCHED_EV_MIGRATE], s->waits ? s->latency / s->waits : 0,
+               s->max_latency, s->metric);
+    }
+
+    int max = 0, last = 0;
+    for (int b = 0; b < NBUCKET; b++)
+    {
+        if (hist[b] > max)
+            max = hist[b];
+        if (hist[b] > 0)
+            last = b;
+    }
+    printf("run-queue latency (us): count\n");
+    for (int b = 0; b <= last && max > 0; b++)
+    {
+        printf("[%d, %d): %d ", b == 0 ? 0 : 1 << (b - 1), 1 << b, hist[b]);
+        for (int j = 0; j < (hist[b] * 40 + max - 1) / max; j++)
+            printf("*");
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int timeline = 0, first = 1;
+
+    if (argc > 1 && strcmp(argv[1], "-t") == 0)
+    {
+        timeline = 1;
+        first = 2;
+    }
+    if (first >= argc)
+    {
+        fprintf(2, "usage: schedtrace [-t] command [args...]\n");
+        exit(1);
+    }
+
+    int self = getpid();
+    sched_trace(1);
+
+    int collector = fork();
+    if (collector < 0)
+    {
+        fprintf(2, "schedtrace: fork failed\n");
+        sched_trace(0);
+        exit(1);
+    }
+    if (collector == 0)
+    {
+        collect(self, getpid());
+        sort_events();
+        analyze(timeline);
+        exit(0);
+    }
+
+    int cmd = fork();
+    if (cmd < 0)
+    {
+        fprintf(2, "schedtrace: fork failed\n");
+    }
+    else if (cmd == 0)
+    {
+        exec(argv[first], argv + first);
+        fprintf(2, "schedtrace: exec %s failed\n", argv[first]);
+        exit(1);
+    }
+
+    int pid, collected = 0;
+    while (cmd > 0 && (pid = wait(0)) >= 0 && pid != cmd)
+        if (pid == collector)
+            collected = 1;
+    int dropped = sched_trace(0);
+    if (!collected)
+        wait(0);
+    printf("dropped %d\n", dropped);
+    exit(0);
+}
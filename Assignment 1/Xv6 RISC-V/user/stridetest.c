@@ -0,0 +1,76 @@
+#include "kernel/types.h"
+#include "kernel/sched.h"
+#include "user/user.h"
+
+// Checks that stride scheduling hands out CPU time in proportion to
+// the tickets of each priority. One CPU bound child per priority
+// spins for RUNTIME ticks, then the achieved share of each child is
+// compared with its target share, both in tenths of a percent.
+// Run it on a single hart, make qemu CPUS=1, so all the children
+// compete for the same CPU.
+
+#define RUNTIME 500 // ticks the children spin for
+#define NCHILD 5    // one child for each priority, 1 to 5
+
+int main(int argc, char **argv)
+{
+    int pids[NCHILD], rutime[NCHILD];
+    int total_tickets = 0, total_rutime = 0, worst = 0;
+
+    if (set_policy(SCHED_STRIDE, getpid()) < 0)
+    {
+        printf("stridetest: set_policy failed\n");
+        exit(1);
+    }
+
+    // the children start spinning together, when end is reached
+    // by the parent's clock, so none of them gets a head start.
+    int end = uptime() + RUNTIME;
+    for (int i = 0; i < NCHILD; i++)
+    {
+        int priority = i + 1;
+        total_tickets += STRIDE_TICKETS(priority);
+        if ((pids[i] = fork()) == 0)
+        {
+            set_priority(priority);
+            while (uptime() < end)
+                ;
+            exit(0);
+        }
+        if (pids[i] < 0)
+        {
+            printf("stridetest: fork failed\n");
+            exit(1);
+        }
+    }
+
+    for (int i = 0; i < NCHILD; i++)
+    {
+        int status;
+        struct perf performance;
+        int pid = wait_stat(&status, &performance);
+        for (int j = 0; j < NCHILD; j++)
+            if (pids[j] == pid)
+                rutime[j] = performance.rutime;
+        total_rutime += performance.rutime;
+    }
+    if (total_rutime == 0)
+    {
+        printf("stridetest: children did not run\n");
+        exit(1);
+    }
+
+    printf("priority\ttickets\ttarget\tachieved\tdeviation\n");
+    for (int i = 0; i < NCHILD; i++)
+    {
+        int tickets = STRIDE_TICKETS(i + 1);
+        int target = 1000 * tickets / total_tickets;
+        int achieved = 1000 * rutime[i] / total_rutime;
+        int deviation = achieved > target ? achieved - target : target - achieved;
+        if (deviation > worst)
+            worst = deviation;
+        printf("%d\t\t%d\t%d\t%d\t\t%d\n", i + 1, tickets, target, achieved, deviation);
+    }
+    printf("max deviation %d/1000\n", worst);
+    exit(0);
+}
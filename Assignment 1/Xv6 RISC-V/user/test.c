@@ -1,18 +1,8 @@
 #include "kernel/types.h"
+#include "kernel/sched.h"
 #include "user/user.h"
 #include "kernel/fcntl.h"
 
-struct perf
-{
-    int ctime;             // process creation time
-    int ttime;             // process termination time
-    int stime;             // the total time the process spent in the SLEEPING state
-    int retime;            // the total time the process spent in the RUNNABLE state
-    int rutime;            // the total time the process spent in the RUNNING state
-    int bursttime;         // process burst time
-    int average_bursttime; // approximate estimated burst time
-};
-
 int main(int argc, char **argv)
 {
     int pid2;
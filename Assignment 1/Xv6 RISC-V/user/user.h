@@ -1,6 +1,9 @@
 struct stat;
 struct rtcdate;
 struct perf;
+struct cpustat;
+struct cpugroup_stat;
+struct sched_event;
 
 // system calls
 int fork(void);
@@ -27,6 +30,18 @@ int uptime(void);
 int trace(int mask, int pid); //todo: try delete names
 int wait_stat(int *, struct perf *);
 int set_priority(int);
+int set_policy(int policy, int pid);
+int set_deadline(int runtime, int period, int deadline);
+int cpustat(struct cpustat *, int);
+int sched_setaffinity(int pid, uint64 mask);
+int sched_getaffinity(int pid, uint64 *mask);
+int sched_trace(int on);
+int sched_trace_read(struct sched_event *, int);
+int sched_settimeslice(int pid, int us);
+int sched_gettimeslice(int pid);
+int cpugroup_create(int quota, int period);
+int cpugroup_join(int pid, int gid);
+int cpugroup_stat(int gid, struct cpugroup_stat *);
 
 // ulib.c
 int stat(const char *, struct stat *);
@@ -38,4 +38,16 @@ entry("sleep");
 entry("uptime");
 entry("trace");
 entry("wait_stat");
-entry("set_priority");
\ No newline at end of file
+entry("set_priority");
+entry("set_policy");
+entry("set_deadline");
+entry("cpustat");
+entry("sched_setaffinity");
+entry("sched_getaffinity");
+entry("sched_trace");
+entry("sched_trace_read");
+entry("sched_settimeslice");
+entry("sched_gettimeslice");
+entry("cpugroup_create");
+entry("cpugroup_join");
+entry("cpugroup_stat");
@@ -92,7 +92,7 @@ int fork(void);
 int growproc(int);
 void proc_mapstacks(pagetable_t);
 pagetable_t proc_pagetable(struct proc *);
-void proc_freepagetable(pagetable_t, uint64);
+void proc_freepagetable(struct proc *, pagetable_t, uint64);
 int kill(int, int);
 struct cpu *mycpu(void);
 struct cpu *getmycpu(void);
@@ -102,6 +102,8 @@ void scheduler(void) __attribute__((noreturn));
 void sched(void);
 void setproc(struct proc *);
 void sleep(void *, struct spinlock *);
+void sleep_until(void *, struct spinlock *, uint);
+void sleep_timeouts(void);
 void userinit(void);
 int wait(uint64);
 void wakeup(void *);
@@ -115,6 +117,7 @@ int sigaction(int signum, struct sigaction *act, struct sigaction *oldact); // T
 void sigret(void);                                                          // Task 2.1.5
 
 struct thread *mythread();          // Task 3.2
+struct thread *thread_at(struct proc *, int);
 int kthread_create(uint64, uint64); // Task 3.2
 int kthread_id();                   // Task 3.2
 void kthread_exit(int);             // Task 3.2
@@ -126,6 +129,14 @@ void bsem_free(int);            // Task 4.1
 void bsem_down(int);            // Task 4.1
 void bsem_up(int);              // Task 4.1
 
+int sched_setaffinity(int, uint64);
+int sched_getaffinity(int, uint64);
+int kthread_setaffinity(int, uint64);
+int kthread_getaffinity(int, uint64);
+int futex(uint64, int, int);
+int ksem_wait(uint64, int);
+int ksem_post(uint64);
+
 // swtch.S
 void swtch(struct context *, struct context *);
 
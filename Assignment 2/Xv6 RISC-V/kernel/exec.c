@@ -22,7 +22,7 @@ int exec(char *path, char **argv)
   struct thread *t = mythread();
   struct thread *t_iter;
 
-  for (t_iter = p->p_threads; t_iter < &p->p_threads[NTHREAD]; t_iter++)
+  for (int slot = 0; (t_iter = thread_at(p, slot)) != 0; slot++)
   {
     acquire(&t_iter->lock);
     if (t_iter->tid != t->tid && t_iter->state != T_UNUSED)
@@ -137,7 +137,7 @@ int exec(char *path, char **argv)
   p->sz = sz;
   t->trapframe->epc = elf.entry; // initial program counter = main
   t->trapframe->sp = sp;         // initial stack pointer
-  proc_freepagetable(oldpagetable, oldsz);
+  proc_freepagetable(p, oldpagetable, oldsz);
 
   // ------------------------ Task 2.1.2 ------------------------
   for (i = 0; i < NUMOFSIGNALS; i++)
@@ -154,7 +154,7 @@ int exec(char *path, char **argv)
 
 bad:
   if (pagetable)
-    proc_freepagetable(pagetable, sz);
+    proc_freepagetable(p, pagetable, sz);
   if (ip)
   {
     iunlockput(ip);
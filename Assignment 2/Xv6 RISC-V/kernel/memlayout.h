@@ -62,6 +62,11 @@
 //   fixed-size stack
 //   expandable heap
 //   ...
-//   TRAPFRAME (p->trapframe, used by the trampoline)
+//   ...
+//   TRAPFRAME_PAGE(1)
+//   TRAPFRAME_PAGE(0) (t->trapframe, used by the trampoline)
 //   TRAMPOLINE (the same page as in the kernel)
-#define TRAPFRAME(i) ((TRAMPOLINE - PGSIZE) + (i * sizeof(struct trapframe)))
+// Trapframe pages are mapped as a process adds threads, each holding
+// the trapframes of THREADS_PER_PAGE thread slots.
+#define TRAPFRAME_PAGE(k) (TRAMPOLINE - ((k) + 1) * PGSIZE)
+#define TRAPFRAME(i) (TRAPFRAME_PAGE((i) / THREADS_PER_PAGE) + ((i) % THREADS_PER_PAGE) * sizeof(struct trapframe))
@@ -4,6 +4,9 @@
 #define SIGKILL 9
 #define SIGSTOP 17
 #define SIGCONT 19
-#define NTHREAD 8
+#define NTHREAD 512 // most threads of a process
 #define STACK_SIZE 4000
 #define MAX_BSEM 128
+#define NWAITQ 64 // sleep()/wakeup() wait queues, hashed by channel
+#define FUTEX_WAIT 0 // futex(): sleep if the word holds val
+#define FUTEX_WAKE 1 // futex(): wake up at most val waiters
@@ -23,6 +23,32 @@ static void freeproc(struct proc *p);
 
 extern char trampoline[]; // trampoline.S
 
+// Threads sleeping on a channel, hashed by the channel, so wakeup()
+// only looks at the threads that may be sleeping on it.
+// A bucket's lock is acquired before the t->lock of any thread on the
+// bucket. A thread may hold its own t->lock when it acquires a bucket's
+// lock, as it is then on no wait queue, but never another thread's:
+// sleep(chan, lk) must not be called with lk a t->lock.
+struct waitqueue
+{
+  struct spinlock lock;
+  struct thread *head;
+} waitqueues[NWAITQ];
+
+// Threads in sleep_until(), for sleep_timeouts() to wake.
+// timed_lock must be acquired before any t->lock.
+struct spinlock timed_lock;
+struct thread *timed_sleepers;
+
+// Serialize FUTEX_WAIT's check of the user word with FUTEX_WAKE,
+// one lock per wait queue of the word's physical address.
+struct spinlock futex_locks[NWAITQ];
+
+// helps ensure that wakeups of kthread_join()ing
+// threads are not lost, as wait_lock does for wait().
+// must be acquired before any t->lock.
+struct spinlock join_lock;
+
 // helps ensure that wakeups of wait()ing
 // parents are not lost. helps obey the
 // memory model when using p->parent.
@@ -50,18 +76,24 @@ void proc_mapstacks(pagetable_t kpgtbl)
 void procinit(void)
 {
   struct proc *p;
-  struct thread *t;
+
+  if (sizeof(struct thread) * THREADS_PER_PAGE > PGSIZE)
+    panic("procinit: thread page");
 
   initlock(&pid_lock, "nextpid");
   initlock(&tid_lock, "nexttid");
   initlock(&wait_lock, "wait_lock");
+  initlock(&join_lock, "join_lock");
+  initlock(&timed_lock, "timed_lock");
+  for (int i = 0; i < NWAITQ; i++)
+  {
+    initlock(&waitqueues[i].lock, "waitqueue");
+    initlock(&futex_locks[i], "futex");
+  }
   for (p = proc; p < &proc[NPROC]; p++)
   {
     initlock(&p->lock, "proc");
-    for (t = p->p_threads; t < &p->p_threads[NTHREAD]; t++)
-    {
-      initlock(&t->lock, "thread");
-    }
+    initlock(&p->thread_lock, "threads");
   }
 }
 
@@ -130,15 +162,77 @@ int alloctid()
   return tid;
 }
 
+// Thread slot i of p, or 0 if p has no slot i.
+// Slots are never taken away from a proc, so no lock is needed.
+struct thread *
+thread_at(struct proc *p, int i)
+{
+  if (i >= NTHREAD || i >= p->nthread_pages * THREADS_PER_PAGE)
+    return 0;
+  return &p->thread_pages[i / THREADS_PER_PAGE][i % THREADS_PER_PAGE];
+}
+
+// Add a page of thread slots to p and put them on the free list,
+// lowest index first. p->thread_lock must be held.
+static int
+growthreads(struct proc *p)
+{
+  struct thread *page;
+  int k = p->nthread_pages;
+
+  if (k == NTHREADPAGE || (page = (struct thread *)kalloc()) == 0)
+    return -1;
+  memset(page, 0, PGSIZE);
+  for (int j = THREADS_PER_PAGE - 1; j >= 0; j--)
+  {
+    struct thread *t = &page[j];
+    initlock(&t->lock, "thread");
+    t->trapframe_index = k * THREADS_PER_PAGE + j;
+    t->last_cpu = -1;
+    if (t->trapframe_index < NTHREAD)
+    {
+      t->free_next = p->free_threads;
+      p->free_threads = t;
+    }
+  }
+  p->thread_pages[k] = page;
+
+  // the slots must be ready before thread_at() returns them.
+  __sync_synchronize();
+  p->nthread_pages = k + 1;
+  return 0;
+}
+
+// Map trapframe page k of p, the first time one of its threads is used.
+// p->thread_lock must be held.
+static int
+maptrapframes(struct proc *p, int k)
+{
+  struct trapframe *tf;
+
+  if ((tf = (struct trapframe *)kalloc()) == 0)
+    return -1;
+  if (mappages(p->pagetable, TRAPFRAME_PAGE(k), PGSIZE, (uint64)tf, PTE_R | PTE_W) < 0)
+  {
+    kfree((void *)tf);
+    return -1;
+  }
+  p->trapframes[k] = tf;
+  return 0;
+}
+
+// Reset t and put it back on p's free list.
 static void
-freethread(struct thread *t)
+freethread(struct proc *p, struct thread *t)
 {
   t->state = T_UNUSED;
   t->chan = 0;
   t->killed = 0;
   t->xstate = 0;
   t->tid = 0;
-  t->trapframe_index = 0;
+  t->affinity = 0;
+  t->last_cpu = -1;
+  t->migrations = 0;
   t->parent = 0;
   if (t->user_trap_backup)
     kfree((void *)t->user_trap_backup);
@@ -147,43 +241,52 @@ freethread(struct thread *t)
     kfree((void *)t->kstack);
   t->kstack = 0;
   t->trapframe = 0;
+
+  acquire(&p->thread_lock);
+  t->free_next = p->free_threads;
+  p->free_threads = t;
+  release(&p->thread_lock);
 }
 
+// Take an unused thread of p off its free list, adding slots
+// and trapframe pages as needed. Returns with t->lock held.
 static struct thread *
 allocthread(struct proc *p)
 {
   struct thread *t;
-  int i = 0;
-  for (t = p->p_threads; t < &p->p_threads[NTHREAD]; t++)
+  int i;
+
+  acquire(&p->thread_lock);
+  if (p->free_threads == 0 && growthreads(p) < 0)
   {
-    if (t != mythread())
-    {
-      acquire(&t->lock);
-      if (t->state == T_UNUSED)
-      {
-        goto found;
-      }
-      else
-      {
-        release(&t->lock);
-      }
-    }
-    i++;
+    release(&p->thread_lock);
+    return 0;
   }
-  return 0;
+  t = p->free_threads;
+  i = t->trapframe_index;
+  if (p->trapframes[i / THREADS_PER_PAGE] == 0 && maptrapframes(p, i / THREADS_PER_PAGE) < 0)
+  {
+    release(&p->thread_lock);
+    return 0;
+  }
+  p->free_threads = t->free_next;
+  t->free_next = 0;
+  release(&p->thread_lock);
 
-found:
+  acquire(&t->lock);
   t->state = T_USED;
   t->killed = 0;
   t->tid = alloctid();
-  t->trapframe_index = i;
+  t->affinity = p->affinity;
+  t->last_cpu = -1;
+  t->migrations = 0;
   t->parent = p;
-  t->trapframe = &p->t_trapframe[i];
+  t->trapframe = &p->trapframes[i / THREADS_PER_PAGE][i % THREADS_PER_PAGE];
 
   // Allocate a trapframe backup page.
   if ((t->user_trap_backup = (struct trapframe *)kalloc()) == 0)
   {
-    freethread(t);
+    freethread(p, t);
     release(&t->lock);
     return 0;
   }
@@ -196,7 +299,7 @@ found:
   // Allocate kernel stack.
   if ((t->kstack = (uint64)kalloc()) == 0)
   {
-    freethread(t);
+    freethread(p, t);
     release(&t->lock);
     return 0;
   }
@@ -232,14 +335,6 @@ found:
   p->pid = allocpid();
   p->state = P_USED;
 
-  // Allocate a trapframe page.
-  if ((p->t_trapframe = (struct trapframe *)kalloc()) == 0)
-  {
-    freeproc(p);
-    release(&p->lock);
-    return 0;
-  }
-
   // An empty user page table.
   p->pagetable = proc_pagetable(p);
   if (p->pagetable == 0)
@@ -258,8 +353,9 @@ found:
   }
   p->signal_mask_backup = 0;
   p->is_stopped_signal_turnon = 0;
+  p->affinity = ~0UL;
 
-  // Allocate thread.
+  // Allocate thread. After freeproc() that is slot 0.
   struct thread *t;
   if ((t = allocthread(p)) == 0)
   {
@@ -279,12 +375,15 @@ found:
 static void
 freeproc(struct proc *p)
 {
-  if (p->t_trapframe)
-    kfree((void *)p->t_trapframe);
-  p->t_trapframe = 0;
   if (p->pagetable)
-    proc_freepagetable(p->pagetable, p->sz);
+    proc_freepagetable(p, p->pagetable, p->sz);
   p->pagetable = 0;
+  for (int k = 0; k < NTHREADPAGE; k++)
+  {
+    if (p->trapframes[k])
+      kfree((void *)p->trapframes[k]);
+    p->trapframes[k] = 0;
+  }
   p->sz = 0;
   p->pid = 0;
   p->parent = 0;
@@ -304,11 +403,16 @@ freeproc(struct proc *p)
   p->signal_mask_backup = 0;
   p->is_stopped_signal_turnon = 0;
   // ------------------------------------------------------------
+  p->affinity = 0;
   // ------------------------- Task 3.1 -------------------------
-  struct thread *t;
-  for (t = p->p_threads; t < &p->p_threads[NTHREAD]; t++)
+  // Free the threads from the last slot down, so the free list
+  // starts at slot 0 again.
+  p->free_threads = 0;
+  for (int i = p->nthread_pages * THREADS_PER_PAGE - 1; i >= 0; i--)
   {
-    freethread(t);
+    struct thread *t = thread_at(p, i);
+    if (t)
+      freethread(p, t);
   }
   // ------------------------------------------------------------
 }
@@ -336,13 +440,22 @@ proc_pagetable(struct proc *p)
     return 0;
   }
 
-  // map the trapframe just below TRAMPOLINE, for trampoline.S.
-  if (mappages(pagetable, TRAPFRAME(0), PGSIZE,
-               (uint64)(p->t_trapframe), PTE_R | PTE_W) < 0)
+  // map the trapframe pages of p's threads below TRAMPOLINE,
+  // for trampoline.S.
+  for (int k = 0; k < NTHREADPAGE; k++)
   {
-    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
-    uvmfree(pagetable, 0);
-    return 0;
+    if (p->trapframes[k] == 0)
+      continue;
+    if (mappages(pagetable, TRAPFRAME_PAGE(k), PGSIZE,
+                 (uint64)(p->trapframes[k]), PTE_R | PTE_W) < 0)
+    {
+      while (--k >= 0)
+        if (p->trapframes[k])
+          uvmunmap(pagetable, TRAPFRAME_PAGE(k), 1, 0);
+      uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+      uvmfree(pagetable, 0);
+      return 0;
+    }
   }
 
   return pagetable;
@@ -350,10 +463,12 @@ proc_pagetable(struct proc *p)
 
 // Free a process's page table, and free the
 // physical memory it refers to.
-void proc_freepagetable(pagetable_t pagetable, uint64 sz)
+void proc_freepagetable(struct proc *p, pagetable_t pagetable, uint64 sz)
 {
   uvmunmap(pagetable, TRAMPOLINE, 1, 0);
-  uvmunmap(pagetable, TRAPFRAME(0), 1, 0);
+  for (int k = 0; k < NTHREADPAGE; k++)
+    if (p->trapframes[k])
+      uvmunmap(pagetable, TRAPFRAME_PAGE(k), 1, 0);
   uvmfree(pagetable, sz);
 }
 
@@ -382,13 +497,14 @@ void userinit(void)
   p->sz = PGSIZE;
 
   // prepare for the very first "return" from kernel to user.
-  p->t_trapframe->epc = 0;     // user program counter
-  p->t_trapframe->sp = PGSIZE; // user stack pointer
+  struct thread *t = thread_at(p, 0);
+  t->trapframe->epc = 0;     // user program counter
+  t->trapframe->sp = PGSIZE; // user stack pointer
 
   safestrcpy(p->name, "initcode", sizeof(p->name));
   p->cwd = namei("/");
 
-  p->p_threads[0].state = T_RUNNABLE;
+  t->state = T_RUNNABLE;
 
   release(&p->lock);
 }
@@ -444,7 +560,7 @@ int fork(void)
   }
   np->sz = p->sz;
 
-  nt = &np->p_threads[0];
+  nt = thread_at(np, 0);
 
   // copy saved user registers.
   *(nt->trapframe) = *(t->trapframe);
@@ -470,6 +586,8 @@ int fork(void)
     np->signal_handlers_mask[i] = p->signal_handlers_mask[i];
   }
   // ------------------------------------------------------------
+  np->affinity = p->affinity;
+  nt->affinity = t->affinity;
 
   release(&np->lock);
 
@@ -540,7 +658,8 @@ void exit(int status)
   p->xstate = status;
   p->state = P_ZOMBIE;
 
-  for (struct thread *t_iter = p->p_threads; t_iter < &p->p_threads[NTHREAD]; t_iter++)
+  struct thread *t_iter;
+  for (int slot = 0; (t_iter = thread_at(p, slot)) != 0; slot++)
   {
     if (t_iter->tid != t->tid && t_iter->state != T_UNUSED)
     {
@@ -620,6 +739,28 @@ int wait(uint64 addr)
   }
 }
 
+// Stop the hart until an interrupt arrives, and count
+// the time it waited as idle time.
+// Must be called with interrupts off.
+static void cpu_idle(struct cpu *c)
+{
+  c->idle_start = r_time();
+  wfi();
+  c->idle += r_time() - c->idle_start;
+  c->idle_start = 0;
+}
+
+// Mask of the harts that have started scheduling.
+static uint64 online_cpus(void)
+{
+  uint64 mask = 0;
+
+  for (int i = 0; i < NCPU; i++)
+    if (cpus[i].start != 0)
+      mask |= 1UL << i;
+  return mask;
+}
+
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
 // Scheduler never returns.  It loops, doing:
@@ -632,14 +773,21 @@ void scheduler(void)
   struct proc *p;
   struct thread *t;
   struct cpu *c = mycpu();
+  int found;
 
   c->proc = 0;
   c->thread = 0;
+  c->start = r_time();
   for (;;)
   {
     // Avoid deadlock by ensuring that devices can interrupt.
     intr_on();
 
+    // Look for work with interrupts off, so an interrupt that
+    // makes a thread RUNNABLE after the search wakes up the
+    // wfi in cpu_idle() instead of being handled before it.
+    intr_off();
+    found = 0;
     for (p = proc; p < &proc[NPROC]; p++)
     {
       if (p->state == P_USED && (p->is_stopped_signal_turnon == 0 || (p->pending_signals & (1 << SIGKILL)) != 0 || ((p->pending_signals & (1 << SIGCONT)) != 0 && (p->signal_mask & (1 << SIGCONT)) == 0)))
@@ -647,11 +795,14 @@ void scheduler(void)
         // Switch to chosen thread.  It is the thread's job
         // to release its lock and then reacquire it
         // before jumping back to us.
-        for (t = p->p_threads; t < &p->p_threads[NTHREAD]; t++)
+        for (int slot = 0; (t = thread_at(p, slot)) != 0; slot++)
         {
           acquire(&t->lock);
-          if (t->state == T_RUNNABLE)
+          if (t->state == T_RUNNABLE && (t->affinity & (1UL << cpuid())) != 0)
           {
+            if (t->last_cpu >= 0 && t->last_cpu != cpuid())
+              t->migrations++;
+            t->last_cpu = cpuid();
             t->state = T_RUNNING;
             c->thread = t;
             c->proc = p;
@@ -660,11 +811,14 @@ void scheduler(void)
             // It should have changed its p->state before coming back.
             c->proc = 0;
             c->thread = 0;
+            found = 1;
           }
           release(&t->lock);
         }
       }
     }
+    if (!found)
+      cpu_idle(c);
   }
 }
 
@@ -725,11 +879,30 @@ void forkret(void)
   usertrapret();
 }
 
+// ------------------------ Wait queues -----------------------
+static struct waitqueue *
+waitqueue_of(void *chan)
+{
+  return &waitqueues[(((uint64)chan * 0x9E3779B97F4A7C15UL) >> 32) % NWAITQ];
+}
+
+// Take t off wq. wq->lock must be held.
+static void
+waitqueue_remove(struct thread *t)
+{
+  *t->wq_pprev = t->wq_next;
+  if (t->wq_next)
+    t->wq_next->wq_pprev = t->wq_pprev;
+  t->wq_next = 0;
+  t->wq_pprev = 0;
+}
+
 // Atomically release lock and sleep on chan.
 // Reacquires lock when awakened.
 void sleep(void *chan, struct spinlock *lk)
 {
   struct thread *t = mythread();
+  struct waitqueue *wq = waitqueue_of(chan);
 
   // Must acquire t->lock in order to
   // change t->state and then call sched.
@@ -737,47 +910,125 @@ void sleep(void *chan, struct spinlock *lk)
   // guaranteed that we won't miss any wakeup
   // (wakeup locks t->lock),
   // so it's okay to release lk.
+  // The wait queue's lock comes first, and
+  // t is on the queue before wakeup can look.
 
+  acquire(&wq->lock);
   acquire(&t->lock); //DOC: sleeplock1
   release(lk);
 
   // Go to sleep.
   t->chan = chan;
   t->state = T_SLEEPING;
+  t->wq_next = wq->head;
+  t->wq_pprev = &wq->head;
+  if (wq->head)
+    wq->head->wq_pprev = &t->wq_next;
+  wq->head = t;
+  release(&wq->lock);
 
   sched();
 
   // Tidy up.
   t->chan = 0;
+  release(&t->lock);
+
+  // wakeup() has taken t off the queue, unless something
+  // else woke t, like a kill or an exiting thread.
+  acquire(&wq->lock);
+  if (t->wq_pprev)
+    waitqueue_remove(t);
+  release(&wq->lock);
 
   // Reacquire original lock.
-  release(&t->lock);
   acquire(lk);
 }
 
-// Wake up all processes sleeping on chan.
-// Must be called without any p->lock.
-void wakeup(void *chan)
+// Like sleep(), but also wake up once ticks reaches deadline.
+void sleep_until(void *chan, struct spinlock *lk, uint deadline)
+{
+  struct thread *t = mythread();
+
+  acquire(&timed_lock);
+  t->wake_tick = deadline;
+  t->timed_next = timed_sleepers;
+  t->timed_pprev = &timed_sleepers;
+  if (timed_sleepers)
+    timed_sleepers->timed_pprev = &t->timed_next;
+  timed_sleepers = t;
+  release(&timed_lock);
+
+  // if the deadline passes before t is asleep,
+  // t is still on the list for the next tick to wake.
+  sleep(chan, lk);
+
+  acquire(&timed_lock);
+  *t->timed_pprev = t->timed_next;
+  if (t->timed_next)
+    t->timed_next->timed_pprev = t->timed_pprev;
+  t->timed_next = 0;
+  t->timed_pprev = 0;
+  release(&timed_lock);
+}
+
+// Wake up the threads in sleep_until() whose deadline has come.
+// Called by clockintr() every tick.
+void sleep_timeouts(void)
 {
-  struct proc *p;
   struct thread *t;
 
-  for (p = proc; p < &proc[NPROC]; p++)
+  acquire(&timed_lock);
+  for (t = timed_sleepers; t; t = t->timed_next)
   {
-    for (t = p->p_threads; t < &p->p_threads[NTHREAD]; t++)
+    if ((int)(ticks - t->wake_tick) < 0)
+      continue;
+    acquire(&t->lock);
+    if (t->state == T_SLEEPING)
+      t->state = T_RUNNABLE;
+    release(&t->lock);
+  }
+  release(&timed_lock);
+}
+
+// Wake up at most n threads sleeping on chan, or all of them if n < 0.
+// Returns the number of threads woken.
+static int
+wakeup_n(void *chan, int n)
+{
+  struct waitqueue *wq = waitqueue_of(chan);
+  struct thread *t, *next;
+  int woken = 0;
+
+  acquire(&wq->lock);
+  for (t = wq->head; t && woken != n; t = next)
+  {
+    next = t->wq_next;
+    if (t->chan != chan || t == mythread())
+      continue;
+    acquire(&t->lock);
+    if (t->state == T_SLEEPING && t->chan == chan)
     {
-      if (t != mythread())
-      {
-        acquire(&t->lock);
-        if (t->state == T_SLEEPING && t->chan == chan)
-        {
-          t->state = T_RUNNABLE;
-        }
-        release(&t->lock);
-      }
+      t->state = T_RUNNABLE;
+      woken++;
     }
+    release(&t->lock);
+    waitqueue_remove(t);
   }
+  release(&wq->lock);
+  return woken;
+}
+
+// Wake up all threads sleeping on chan.
+// Only looks at the threads on chan's wait queue,
+// so the cost grows with the number of sleepers.
+// Must be called without any t->lock but the caller's own,
+// since it acquires the t->lock of each sleeper under the
+// bucket's lock.
+void wakeup(void *chan)
+{
+  wakeup_n(chan, -1);
 }
+// ------------------------------------------------------------
 
 // ------------------------ Task 2.2.1 ------------------------
 
@@ -871,9 +1122,25 @@ void procdump(void)
       state = states[p->state];
     else
       state = "???";
-    printf("%d %s %s", p->pid, state, p->name);
+    int migrations = 0;
+    struct thread *t;
+    for (int slot = 0; (t = thread_at(p, slot)) != 0; slot++)
+      migrations += t->migrations;
+    printf("%d %s %s migrations %d", p->pid, state, p->name, migrations);
     printf("\n");
   }
+
+  uint64 now = r_time();
+  for (int i = 0; i < NCPU; i++)
+  {
+    struct cpu *c = &cpus[i];
+    if (c->start == 0 || now == c->start)
+      continue;
+    uint64 idle = c->idle;
+    if (c->idle_start != 0)
+      idle += now - c->idle_start;
+    printf("cpu %d idle %d%%\n", i, (int)(idle * 100 / (now - c->start)));
+  }
 }
 // ------------------------ Task 2.1.3 ------------------------
 uint sigprocmask(uint sigmask)
@@ -990,7 +1257,8 @@ void kthread_exit(int status)
 
   acquire(&p->lock);
   int num_threads_running = 0;
-  for (struct thread *t_iter = p->p_threads; t_iter < &p->p_threads[NTHREAD]; t_iter++)
+  struct thread *t_iter;
+  for (int slot = 0; (t_iter = thread_at(p, slot)) != 0; slot++)
   {
     acquire(&t_iter->lock);
     if (t_iter->tid != t->tid && t_iter->state != T_UNUSED && t_iter->state != T_ZOMBIE)
@@ -1006,6 +1274,7 @@ void kthread_exit(int status)
     exit(status);
   }
 
+  acquire(&join_lock);
   acquire(&t->lock);
   t->xstate = status;
   t->state = T_ZOMBIE;
@@ -1014,6 +1283,7 @@ void kthread_exit(int status)
 
   //wake up threads waiting for this thread to exit
   wakeup(t);
+  release(&join_lock);
 
   // Jump into the scheduler, never to return.
   sched();
@@ -1023,30 +1293,40 @@ void kthread_exit(int status)
 int kthread_join(int thread_id, int *status)
 {
   struct proc *p = myproc();
+  struct thread *t_join;
 
-  for (struct thread *t_join = p->p_threads; t_join < &p->p_threads[NTHREAD]; t_join++)
+  // sleep on join_lock rather than t_join->lock: see struct waitqueue.
+  acquire(&join_lock);
+  for (int slot = 0; (t_join = thread_at(p, slot)) != 0; slot++)
   {
     acquire(&t_join->lock);
     if (thread_id == t_join->tid)
     {
-      while (t_join->state != T_UNUSED && t_join->state != T_ZOMBIE)
-        sleep(t_join, &t_join->lock);
+      while (t_join->tid == thread_id && t_join->state != T_UNUSED && t_join->state != T_ZOMBIE)
+      {
+        release(&t_join->lock);
+        sleep(t_join, &join_lock);
+        acquire(&t_join->lock);
+      }
 
-      if (t_join->state == T_ZOMBIE)
+      if (t_join->tid == thread_id && t_join->state == T_ZOMBIE)
       {
         if (status != 0 && copyout(p->pagetable, (uint64)status, (char *)&t_join->xstate, sizeof(t_join->xstate)) < 0)
         {
           release(&t_join->lock);
+          release(&join_lock);
           return -1;
         }
-        freethread(t_join);
+        freethread(p, t_join);
       }
 
       release(&t_join->lock);
+      release(&join_lock);
       return 0;
     }
     release(&t_join->lock);
   }
+  release(&join_lock);
 
   return -1;
 }
@@ -1117,3 +1397,280 @@ void bsem_up(int descriptor)
   release(&bSemaphore_array[descriptor].lock);
 }
 // ------------------------------------------------------------
+// ------------------------- Affinity -------------------------
+// Find the process with the given pid, or the caller when pid is 0.
+// Returns with p->lock held, or 0 if there is no such process.
+static struct proc *
+find_proc(int pid)
+{
+  struct proc *p;
+
+  if (pid == 0)
+  {
+    p = myproc();
+    acquire(&p->lock);
+    return p;
+  }
+  for (p = proc; p < &proc[NPROC]; p++)
+  {
+    acquire(&p->lock);
+    if (p->pid == pid && p->state != P_UNUSED)
+      return p;
+    release(&p->lock);
+  }
+  return 0;
+}
+
+// Find the thread of the calling process with the given tid,
+// or the calling thread when tid is 0.
+// Returns with t->lock held, or 0 if there is no such thread.
+static struct thread *
+find_thread(int tid)
+{
+  struct proc *p = myproc();
+  struct thread *t;
+
+  if (tid == 0)
+  {
+    t = mythread();
+    acquire(&t->lock);
+    return t;
+  }
+  for (int slot = 0; (t = thread_at(p, slot)) != 0; slot++)
+  {
+    acquire(&t->lock);
+    if (t->tid == tid && t->state != T_UNUSED)
+      return t;
+    release(&t->lock);
+  }
+  return 0;
+}
+
+// Let every thread of the process with the given pid, or of the
+// caller when pid is 0, run only on the harts in mask, bit i for
+// hart i. Threads created later get the same mask.
+// Fails if mask has none of the harts that are up.
+int sched_setaffinity(int pid, uint64 mask)
+{
+  struct proc *p;
+
+  if ((mask & online_cpus()) == 0)
+    return -1;
+  if ((p = find_proc(pid)) == 0)
+    return -1;
+  p->affinity = mask;
+  struct thread *t;
+  for (int slot = 0; (t = thread_at(p, slot)) != 0; slot++)
+  {
+    acquire(&t->lock);
+    t->affinity = mask;
+    release(&t->lock);
+  }
+  int self = p == myproc();
+  release(&p->lock);
+
+  // the caller may be on a hart it has just left.
+  if (self)
+    yield();
+  return 0;
+}
+
+// Copy the affinity of new threads of the process with the given
+// pid, or of the caller when pid is 0, to user address addr.
+int sched_getaffinity(int pid, uint64 addr)
+{
+  struct proc *p;
+  uint64 mask;
+
+  if ((p = find_proc(pid)) == 0)
+    return -1;
+  mask = p->affinity & online_cpus();
+  release(&p->lock);
+
+  return copyout(myproc()->pagetable, addr, (char *)&mask, sizeof(mask));
+}
+
+// Let the thread of the calling process with the given tid, or the
+// calling thread when tid is 0, run only on the harts in mask.
+int kthread_setaffinity(int tid, uint64 mask)
+{
+  struct thread *t;
+
+  if ((mask & online_cpus()) == 0)
+    return -1;
+  if ((t = find_thread(tid)) == 0)
+    return -1;
+  t->affinity = mask;
+  int self = t == mythread();
+  release(&t->lock);
+
+  if (self)
+    yield();
+  return 0;
+}
+
+// Copy the affinity of the thread of the calling process with the
+// given tid, or of the calling thread when tid is 0, to user address addr.
+int kthread_getaffinity(int tid, uint64 addr)
+{
+  struct thread *t;
+  uint64 mask;
+
+  if ((t = find_thread(tid)) == 0)
+    return -1;
+  mask = t->affinity & online_cpus();
+  release(&t->lock);
+
+  return copyout(myproc()->pagetable, addr, (char *)&mask, sizeof(mask));
+}
+// ------------------------------------------------------------
+// ------------------------- Futexes --------------------------
+// A futex is a user word that threads wait on in the kernel only when
+// the word says they must, so user-space locks cost no system call
+// unless they are contended. Waiters sleep on the physical address of
+// the word, which is the same for every thread that maps it.
+
+// The physical address of the aligned user word at addr, or 0.
+static uint64
+futex_key(uint64 addr)
+{
+  uint64 pa;
+
+  if (addr % sizeof(int) != 0)
+    return 0;
+  if ((pa = walkaddr(myproc()->pagetable, addr)) == 0)
+    return 0;
+  return pa + addr % PGSIZE;
+}
+
+static struct spinlock *
+futex_lock(uint64 pa)
+{
+  return &futex_locks[waitqueue_of((void *)pa) - waitqueues];
+}
+
+// FUTEX_WAIT: sleep until a FUTEX_WAKE on addr, if the word at addr
+// still holds val. Returns 0 when woken, or -1 if the word didn't hold
+// val or the thread was killed; callers check the word again either way.
+// FUTEX_WAKE: wake up at most val threads waiting on addr, or all of
+// them if val < 0. Returns the number of threads woken.
+int futex(uint64 addr, int op, int val)
+{
+  struct spinlock *lk;
+  uint64 pa;
+  int ret;
+
+  if ((pa = futex_key(addr)) == 0)
+    return -1;
+  lk = futex_lock(pa);
+
+  acquire(lk);
+  if (op == FUTEX_WAIT)
+  {
+    // FUTEX_WAKE holds lk, so it can't come between the check and
+    // the sleep: a waker changes the word before it wakes.
+    ret = -1;
+    if (*(volatile int *)pa == val)
+    {
+      sleep((void *)pa, lk);
+      ret = mythread()->killed || myproc()->killed ? -1 : 0;
+    }
+  }
+  else if (op == FUTEX_WAKE)
+  {
+    ret = wakeup_n((void *)pa, val);
+  }
+  else
+  {
+    ret = -1;
+  }
+  release(lk);
+  return ret;
+}
+// ------------------------------------------------------------
+// ------------------------ Semaphores ------------------------
+// A counting semaphore is a pair of aligned user words, the count
+// and the number of threads blocked in ksem_wait(). User code takes
+// the count down while it is above 0 and puts it up on its own, and
+// calls ksem_post() only when the waiters word says someone sleeps.
+// The kernel changes the count atomically too, as user threads may
+// change it at any time, and keys waiters like futex().
+
+// The physical address of the semaphore at addr, or 0.
+static uint64
+sem_key(uint64 addr)
+{
+  if (addr % (2 * sizeof(int)) != 0)
+    return 0;
+  return futex_key(addr);
+}
+
+// Take the count of the semaphore at addr down by one, sleeping until
+// it is above 0, or for at most timeout ticks if timeout >= 0.
+// Returns 0, or -1 if it timed out or the thread was killed.
+int ksem_wait(uint64 addr, int timeout)
+{
+  struct spinlock *lk;
+  uint64 pa;
+  int *value, *waiters;
+  int ret = -1;
+
+  if ((pa = sem_key(addr)) == 0)
+    return -1;
+  value = (int *)pa;
+  waiters = value + 1;
+  lk = futex_lock(pa);
+  uint deadline = ticks + timeout;
+
+  acquire(lk);
+  // count ourselves before looking at the count. a post puts the
+  // count up before it looks at waiters, so one of us sees the other.
+  __atomic_fetch_add(waiters, 1, __ATOMIC_SEQ_CST);
+  for (;;)
+  {
+    int v = __atomic_load_n(value, __ATOMIC_SEQ_CST);
+    if (v > 0)
+    {
+      if (__sync_bool_compare_and_swap(value, v, v - 1))
+      {
+        ret = 0;
+        break;
+      }
+      continue;
+    }
+    if (mythread()->killed || myproc()->killed)
+      break;
+    if (timeout >= 0 && (int)(ticks - deadline) >= 0)
+      break;
+    if (timeout >= 0)
+      sleep_until((void *)pa, lk, deadline);
+    else
+      sleep((void *)pa, lk);
+  }
+  __atomic_fetch_sub(waiters, 1, __ATOMIC_SEQ_CST);
+
+  // a post may have woken us instead of a waiter that still sleeps.
+  if (ret < 0 && __atomic_load_n(value, __ATOMIC_SEQ_CST) > 0)
+    wakeup_n((void *)pa, 1);
+  release(lk);
+  return ret;
+}
+
+// Wake up a thread in ksem_wait() on the semaphore at addr,
+// whose count the caller has put up. Returns the number woken.
+int ksem_post(uint64 addr)
+{
+  struct spinlock *lk;
+  uint64 pa;
+  int woken;
+
+  if ((pa = sem_key(addr)) == 0)
+    return -1;
+  lk = futex_lock(pa);
+
+  acquire(lk);
+  woken = wakeup_n((void *)pa, 1);
+  release(lk);
+  return woken;
+}
+// ------------------------------------------------------------
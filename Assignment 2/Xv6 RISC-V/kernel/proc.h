@@ -35,6 +35,9 @@ struct cpu
   struct context context; // swtch() here to enter scheduler().
   int noff;               // Depth of push_off() nesting.
   int intena;             // Were interrupts enabled before push_off()?
+  uint64 start;           // r_time() when this cpu entered scheduler()
+  uint64 idle;            // r_time() units spent waiting in wfi
+  uint64 idle_start;      // r_time() when the current wait began, or 0
 };
 
 extern struct cpu cpus[NCPU];
@@ -92,6 +95,10 @@ struct trapframe
   /* 280 */ uint64 t6;
 };
 
+// thread slots, and their trapframes, that fit in a page.
+#define THREADS_PER_PAGE (PGSIZE / sizeof(struct trapframe))
+#define NTHREADPAGE ((NTHREAD + THREADS_PER_PAGE - 1) / THREADS_PER_PAGE)
+
 enum procstate
 {
   P_UNUSED,
@@ -118,11 +125,26 @@ struct thread
   int killed;             // If non-zero, have been killed
   int xstate;             // Exit status to be returned to parent's wait
   int tid;                // Thread ID
-  int trapframe_index;           // Thread's Trapframe index
+  int trapframe_index;    // Thread's slot, and Trapframe, index in its process
+  uint64 affinity;        // Harts the thread may run on, bit i for hart i
+  int last_cpu;           // Hart the thread last ran on, or -1
+  int migrations;         // Times the thread ran on a different hart than before
+
+  // the lock of the wait queue of chan must be held when using these:
+  struct thread *wq_next;   // Next thread sleeping on the same wait queue
+  struct thread **wq_pprev; // Link to this thread in the wait queue, or 0
+
+  // timed_lock must be held when using these:
+  uint wake_tick;              // ticks at which sleep_until() gives up
+  struct thread *timed_next;   // Next thread in sleep_until()
+  struct thread **timed_pprev; // Link to this thread in timed_sleepers, or 0
 
   // thread_tree_lock must be held when using this:
   struct proc *parent; // Parent process
 
+  // p->thread_lock must be held when using this:
+  struct thread *free_next; // Next unused thread of the process
+
   // these are private to the thread, so t->lock need not be held.
   struct trapframe *user_trap_backup; // Trapframe backup
   uint64 kstack;                      // Virtual address of kernel stack
@@ -147,7 +169,7 @@ struct proc
   // these are private to the process, so p->lock need not be held.
   uint64 sz;                     // Size of process memory (bytes)
   pagetable_t pagetable;         // User page table
-  struct trapframe *t_trapframe; // data page for trampoline.S
+  struct trapframe *trapframes[NTHREADPAGE]; // data pages for trampoline.S, or 0
   struct file *ofile[NOFILE]; // Open files
   struct inode *cwd;          // Current directory
   char name[16];              // Process name (debugging)
@@ -162,8 +184,15 @@ struct proc
   int is_stopped_signal_turnon;
   // ------------------------------------------------------------
   // ------------------------- Task 4.1 -------------------------
-  struct thread p_threads[NTHREAD];  // Process's threads table
+  // Process's threads table, THREADS_PER_PAGE slots to a page. Pages
+  // are added as threads are, and kept for the next process in this
+  // proc slot, so the slots can be scanned without a lock.
+  struct spinlock thread_lock;              // Protects the free list and adding pages
+  struct thread *thread_pages[NTHREADPAGE]; // Pages of thread slots
+  int nthread_pages;                        // Pages in use, only ever grows
+  struct thread *free_threads;              // Unused threads, linked by free_next
   // ------------------------------------------------------------
+  uint64 affinity; // Affinity of new threads, bit i for hart i
 };
 
 #define S_UNUSED 0
@@ -17,7 +17,7 @@ void sig_kill(int signum)
     struct proc *p = myproc();
     struct thread *t;
     p->killed = 1;
-    for (t = p->p_threads; t < &p->p_threads[NTHREAD]; t++)
+    for (int slot = 0; (t = thread_at(p, slot)) != 0; slot++)
     {
         acquire(&t->lock);
         if (t->state == T_SLEEPING)
@@ -115,6 +115,16 @@ extern uint64 sys_bsem_free(void);  // Task 4.1
 extern uint64 sys_bsem_up(void);    // Task 4.1
 extern uint64 sys_bsem_down(void);  // Task 4.1
 
+extern uint64 sys_sched_setaffinity(void);
+extern uint64 sys_sched_getaffinity(void);
+extern uint64 sys_kthread_setaffinity(void);
+extern uint64 sys_kthread_getaffinity(void);
+
+extern uint64 sys_futex(void);
+
+extern uint64 sys_ksem_wait(void);
+extern uint64 sys_ksem_post(void);
+
 static uint64 (*syscalls[])(void) = {
     [SYS_fork] sys_fork,
     [SYS_exit] sys_exit,
@@ -148,6 +158,13 @@ static uint64 (*syscalls[])(void) = {
     [SYS_bsem_free] sys_bsem_free,
     [SYS_bsem_up] sys_bsem_up,
     [SYS_bsem_down] sys_bsem_down,
+    [SYS_sched_setaffinity] sys_sched_setaffinity,
+    [SYS_sched_getaffinity] sys_sched_getaffinity,
+    [SYS_kthread_setaffinity] sys_kthread_setaffinity,
+    [SYS_kthread_getaffinity] sys_kthread_getaffinity,
+    [SYS_futex] sys_futex,
+    [SYS_ksem_wait] sys_ksem_wait,
+    [SYS_ksem_post] sys_ksem_post,
 };
 
 void syscall(void)
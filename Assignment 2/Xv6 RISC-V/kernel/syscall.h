@@ -34,3 +34,13 @@
 #define SYS_bsem_free 30
 #define SYS_bsem_up 31
 #define SYS_bsem_down 32
+
+#define SYS_sched_setaffinity 33
+#define SYS_sched_getaffinity 34
+#define SYS_kthread_setaffinity 35
+#define SYS_kthread_getaffinity 36
+
+#define SYS_futex 37
+
+#define SYS_ksem_wait 38
+#define SYS_ksem_post 39
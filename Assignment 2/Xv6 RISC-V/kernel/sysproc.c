@@ -223,3 +223,96 @@ sys_bsem_down(void)
   return 0;
 }
 // ------------------------------------------------------------
+// ------------------------- Affinity -------------------------
+uint64
+sys_sched_setaffinity(void)
+{
+  int pid;
+  uint64 mask;
+
+  if (argint(0, &pid) < 0)
+    return -1;
+  if (argaddr(1, &mask) < 0)
+    return -1;
+  return sched_setaffinity(pid, mask);
+}
+
+uint64
+sys_sched_getaffinity(void)
+{
+  int pid;
+  uint64 mask;
+
+  if (argint(0, &pid) < 0)
+    return -1;
+  if (argaddr(1, &mask) < 0)
+    return -1;
+  return sched_getaffinity(pid, mask);
+}
+
+uint64
+sys_kthread_setaffinity(void)
+{
+  int tid;
+  uint64 mask;
+
+  if (argint(0, &tid) < 0)
+    return -1;
+  if (argaddr(1, &mask) < 0)
+    return -1;
+  return kthread_setaffinity(tid, mask);
+}
+
+uint64
+sys_kthread_getaffinity(void)
+{
+  int tid;
+  uint64 mask;
+
+  if (argint(0, &tid) < 0)
+    return -1;
+  if (argaddr(1, &mask) < 0)
+    return -1;
+  return kthread_getaffinity(tid, mask);
+}
+// ------------------------------------------------------------
+// ------------------------- Futexes --------------------------
+uint64
+sys_futex(void)
+{
+  uint64 addr;
+  int op, val;
+
+  if (argaddr(0, &addr) < 0)
+    return -1;
+  if (argint(1, &op) < 0)
+    return -1;
+  if (argint(2, &val) < 0)
+    return -1;
+  return futex(addr, op, val);
+}
+// ------------------------------------------------------------
+// ------------------------ Semaphores ------------------------
+uint64
+sys_ksem_wait(void)
+{
+  uint64 addr;
+  int timeout;
+
+  if (argaddr(0, &addr) < 0)
+    return -1;
+  if (argint(1, &timeout) < 0)
+    return -1;
+  return ksem_wait(addr, timeout);
+}
+
+uint64
+sys_ksem_post(void)
+{
+  uint64 addr;
+
+  if (argaddr(0, &addr) < 0)
+    return -1;
+  return ksem_post(addr);
+}
+// ------------------------------------------------------------
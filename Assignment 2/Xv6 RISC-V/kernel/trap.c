@@ -181,6 +181,7 @@ void clockintr()
   ticks++;
   wakeup(&ticks);
   release(&tickslock);
+  sleep_timeouts();
 }
 
 // check if it's an external interrupt or software interrupt,
@@ -0,0 +1,586 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+#include "kernel/myParam.h"
+#include "user/usync.h"
+#include "user/Csemaphore.h"
+
+//
+// Synchronization micro-benchmarks.  bench without arguments runs them
+// all and bench <name> runs <name> only.  Each prints its timings in
+// ticks and in microseconds, a tick being about 100000us on qemu.
+//
+
+#define US_PER_TICK 100000 // timer interrupt interval of start.c, in microseconds
+#define ROUNDS 1000        // ping-pong round trips per measurement
+#define SLEEPERS 32        // processes blocked in read() during a loaded run
+#define LOCKS 100000       // acquire/release pairs per lock measurement
+#define OPS 20000          // operations per thread in a throughput run
+#define HANDOFFS 1000      // condition variable and barrier rounds per thread
+#define WORKERS 8          // most threads in a throughput run
+#define SPAWN 256          // threads alive at once in thread_scale
+#define SLOTS 16           // bounded buffer of producer_consumer
+#define ITEMS 20000        // items through the buffer per run
+#define PRODUCERS 2
+#define CONSUMERS 2
+
+int ping, pong;
+
+void pong_thread()
+{
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        bsem_down(ping);
+        bsem_up(pong);
+    }
+    kthread_exit(0);
+}
+
+// bounce between two threads of this process through two binary
+// semaphores ROUNDS times. every round trip is two bsem_up() wakeups.
+// returns the number of ticks it took.
+int bsem_pingpong(char *s)
+{
+    void *stack = malloc(STACK_SIZE);
+
+    if ((ping = bsem_alloc()) < 0 || (pong = bsem_alloc()) < 0)
+    {
+        printf("%s: bsem_alloc failed\n", s);
+        exit(1);
+    }
+    // new binary semaphores are up.
+    bsem_down(ping);
+    bsem_down(pong);
+
+    int tid = kthread_create(pong_thread, stack);
+    if (tid < 0)
+    {
+        printf("%s: kthread_create failed\n", s);
+        exit(1);
+    }
+
+    int start = uptime();
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        bsem_up(ping);
+        bsem_down(pong);
+    }
+    int elapsed = uptime() - start;
+
+    kthread_join(tid, 0);
+    free(stack);
+    bsem_free(ping);
+    bsem_free(pong);
+    return elapsed;
+}
+
+// fork n children that block on hold[0] until the parent closes hold[1],
+// so there are sleeping threads that a wakeup() must not have to visit.
+int spawn_sleepers(int n, int hold[2])
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        int pid = fork();
+        if (pid < 0)
+            break;
+        if (pid == 0)
+        {
+            char c;
+            close(hold[1]);
+            read(hold[0], &c, 1);
+            exit(0);
+        }
+    }
+    return i;
+}
+
+void reap_sleepers(int n, int hold[2])
+{
+    close(hold[1]);
+    close(hold[0]);
+    for (int i = 0; i < n; i++)
+        wait(0);
+}
+
+// bsem ping-pong latency, alone and with SLEEPERS other threads asleep.
+// with wait queues hashed by channel the two should be about the same.
+void bsem_latency(char *s)
+{
+    int populations[] = {0, SLEEPERS};
+
+    for (int i = 0; i < sizeof(populations) / sizeof(populations[0]); i++)
+    {
+        int hold[2];
+        if (pipe(hold) < 0)
+        {
+            printf("%s: pipe failed\n", s);
+            exit(1);
+        }
+        int n = spawn_sleepers(populations[i], hold);
+        int ticks = bsem_pingpong(s);
+        reap_sleepers(n, hold);
+
+        printf("%s: sleepers %d round trips %d ticks %d us per round trip %d\n",
+               s, n, ROUNDS, ticks, ticks * US_PER_TICK / ROUNDS);
+    }
+}
+
+struct mutex mutex;
+int counter;
+
+void counter_thread()
+{
+    for (int i = 0; i < LOCKS; i++)
+    {
+        mutex_lock(&mutex);
+        counter++;
+        mutex_unlock(&mutex);
+    }
+    kthread_exit(0);
+}
+
+void print_locks(char *s, char *lock, int pairs, int ticks)
+{
+    printf("%s: %s pairs %d ticks %d ns per pair %d\n",
+           s, lock, pairs, ticks, (int)((uint64)ticks * US_PER_TICK * 1000 / pairs));
+}
+
+// uncontended acquire/release pairs of a binary semaphore, two system
+// calls each, and of a futex mutex, which stays in user space.
+// then two threads count to 2 * LOCKS under the futex mutex.
+void futex_mutex(char *s)
+{
+    int sem, start, ticks;
+
+    if ((sem = bsem_alloc()) < 0)
+    {
+        printf("%s: bsem_alloc failed\n", s);
+        exit(1);
+    }
+    start = uptime();
+    for (int i = 0; i < LOCKS; i++)
+    {
+        bsem_down(sem);
+        bsem_up(sem);
+    }
+    print_locks(s, "bsem", LOCKS, uptime() - start);
+    bsem_free(sem);
+
+    start = uptime();
+    for (int i = 0; i < LOCKS; i++)
+    {
+        mutex_lock(&mutex);
+        mutex_unlock(&mutex);
+    }
+    print_locks(s, "futex", LOCKS, uptime() - start);
+
+    void *stack = malloc(STACK_SIZE);
+    counter = 0;
+    start = uptime();
+    int tid = kthread_create(counter_thread, stack);
+    if (tid < 0)
+    {
+        printf("%s: kthread_create failed\n", s);
+        exit(1);
+    }
+    for (int i = 0; i < LOCKS; i++)
+    {
+        mutex_lock(&mutex);
+        counter++;
+        mutex_unlock(&mutex);
+    }
+    kthread_join(tid, 0);
+    ticks = uptime() - start;
+    free(stack);
+    if (counter != 2 * LOCKS)
+    {
+        printf("%s: counted %d, not %d\n", s, counter, 2 * LOCKS);
+        exit(1);
+    }
+    print_locks(s, "futex contended", 2 * LOCKS, ticks);
+}
+
+// ---------------------- usync throughput ----------------------
+// n threads of this process, the main thread being one of them, run
+// the same work. Contended, they all use lock 0; uncontended, each
+// has a lock of its own.
+
+struct mutex mutexes[WORKERS];
+struct rwlock rwlocks[WORKERS];
+int counters[WORKERS];
+struct mutex turn_mutex;
+struct cond turn_cond;
+int turn;
+struct barrier barrier;
+
+int nworkers, contended, next_worker;
+void (*work)(int);
+
+void worker()
+{
+    work(__atomic_add_fetch(&next_worker, 1, __ATOMIC_SEQ_CST));
+    kthread_exit(0);
+}
+
+// run f in n threads. returns the number of ticks it took.
+int run_workers(char *s, void f(int), int n, int shared)
+{
+    void *stacks[WORKERS];
+    int tids[WORKERS];
+
+    work = f;
+    nworkers = n;
+    contended = shared;
+    next_worker = 0;
+    memset(counters, 0, sizeof(counters));
+
+    int start = uptime();
+    for (int i = 1; i < n; i++)
+    {
+        stacks[i] = malloc(STACK_SIZE);
+        if ((tids[i] = kthread_create(worker, stacks[i])) < 0)
+        {
+            printf("%s: kthread_create failed\n", s);
+            exit(1);
+        }
+    }
+    f(0);
+    for (int i = 1; i < n; i++)
+    {
+        kthread_join(tids[i], 0);
+        free(stacks[i]);
+    }
+    return uptime() - start;
+}
+
+void print_throughput(char *s, char *what, int n, int shared, int ops, int ticks)
+{
+    // a run shorter than a tick took less than 1 tick.
+    int per_sec = (int)((uint64)ops * 1000000 / ((uint64)(ticks > 0 ? ticks : 1) * US_PER_TICK));
+
+    printf("%s: %s threads %d %s ops %d ticks %d ops per sec %s%d\n",
+           s, what, n, shared ? "contended" : "uncontended", ops, ticks,
+           ticks > 0 ? "" : ">", per_sec);
+}
+
+void mutex_work(int id)
+{
+    int i = contended ? 0 : id;
+
+    for (int op = 0; op < OPS; op++)
+    {
+        mutex_lock(&mutexes[i]);
+        counters[i]++;
+        mutex_unlock(&mutexes[i]);
+    }
+}
+
+void rdlock_work(int id)
+{
+    int i = contended ? 0 : id;
+
+    for (int op = 0; op < OPS; op++)
+    {
+        rwlock_rdlock(&rwlocks[i]);
+        rwlock_unlock(&rwlocks[i]);
+    }
+}
+
+void wrlock_work(int id)
+{
+    int i = contended ? 0 : id;
+
+    for (int op = 0; op < OPS; op++)
+    {
+        rwlock_wrlock(&rwlocks[i]);
+        counters[i]++;
+        rwlock_unlock(&rwlocks[i]);
+    }
+}
+
+// pass a turn around the threads in order, HANDOFFS times each.
+void cond_work(int id)
+{
+    for (int round = 0; round < HANDOFFS; round++)
+    {
+        mutex_lock(&turn_mutex);
+        while (turn % nworkers != id)
+            cond_wait(&turn_cond, &turn_mutex);
+        turn++;
+        cond_broadcast(&turn_cond);
+        mutex_unlock(&turn_mutex);
+    }
+}
+
+void barrier_work(int id)
+{
+    for (int round = 0; round < HANDOFFS; round++)
+        barrier_wait(&barrier);
+}
+
+// the counters of the locks that n threads used must add up.
+void check_counters(char *s, char *what, int n)
+{
+    int sum = 0;
+
+    for (int i = 0; i < WORKERS; i++)
+        sum += counters[i];
+    if (sum != n * OPS)
+    {
+        printf("%s: %s counted %d, not %d\n", s, what, sum, n * OPS);
+        exit(1);
+    }
+}
+
+// throughput of the usync primitives at 2, 4 and 8 threads.
+// mutexes and rwlocks run contended and uncontended;
+// condition variables and barriers always make threads wait.
+void usync_throughput(char *s)
+{
+    int threads[] = {2, 4, WORKERS};
+
+    for (int t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+    {
+        int n = threads[t];
+
+        for (int shared = 0; shared <= 1; shared++)
+        {
+            int ticks = run_workers(s, mutex_work, n, shared);
+            check_counters(s, "mutex", n);
+            print_throughput(s, "mutex", n, shared, n * OPS, ticks);
+
+            ticks = run_workers(s, rdlock_work, n, shared);
+            print_throughput(s, "rwlock read", n, shared, n * OPS, ticks);
+
+            ticks = run_workers(s, wrlock_work, n, shared);
+            check_counters(s, "rwlock write", n);
+            print_throughput(s, "rwlock write", n, shared, n * OPS, ticks);
+        }
+
+        turn = 0;
+        int ticks = run_workers(s, cond_work, n, 1);
+        print_throughput(s, "cond handoff", n, 1, n * HANDOFFS, ticks);
+
+        barrier_init(&barrier, n);
+        ticks = run_workers(s, barrier_work, n, 1);
+        print_throughput(s, "barrier", n, 1, n * HANDOFFS, ticks);
+    }
+}
+// ------------------------------------------------------------
+
+// ----------------------- thread_scale -----------------------
+struct barrier spawned;
+
+void spawn_thread()
+{
+    barrier_wait(&spawned);
+    kthread_exit(0);
+}
+
+// create SPAWN threads, which wait at a barrier until all of them are
+// up, and join them; twice, the second time in thread slots the
+// process already has.
+void thread_scale(char *s)
+{
+    static void *stacks[SPAWN];
+    static int tids[SPAWN];
+
+    for (int round = 0; round < 2; round++)
+    {
+        barrier_init(&spawned, SPAWN + 1);
+        int start = uptime();
+        for (int i = 0; i < SPAWN; i++)
+        {
+            stacks[i] = malloc(STACK_SIZE);
+            if ((tids[i] = kthread_create(spawn_thread, stacks[i])) < 0)
+            {
+                printf("%s: kthread_create failed after %d threads\n", s, i);
+                exit(1);
+            }
+        }
+        barrier_wait(&spawned);
+        for (int i = 0; i < SPAWN; i++)
+        {
+            kthread_join(tids[i], 0);
+            free(stacks[i]);
+        }
+        int ticks = uptime() - start;
+
+        printf("%s: round %d threads %d ticks %d us per thread %d\n",
+               s, round, SPAWN, ticks, ticks * US_PER_TICK / SPAWN);
+    }
+}
+// ------------------------------------------------------------
+
+// --------------------- producer_consumer ---------------------
+// a bounded buffer guarded by three counting semaphores, either csem
+// on binary semaphores or usync sem on the kernel's.
+
+#define EMPTY 0 // free slots
+#define FULL 1  // items in the buffer
+#define GUARD 2 // the buffer itself
+
+struct counting_semaphore csems[3];
+struct sem sems[3];
+int use_csem;
+int buffer[SLOTS];
+int in, out, consumed;
+
+void down(int i)
+{
+    if (use_csem)
+        csem_down(&csems[i]);
+    else
+        sem_wait(&sems[i]);
+}
+
+void up(int i)
+{
+    if (use_csem)
+        csem_up(&csems[i]);
+    else
+        sem_post(&sems[i]);
+}
+
+void pc_work(int id)
+{
+    if (id < PRODUCERS)
+    {
+        for (int i = 0; i < ITEMS / PRODUCERS; i++)
+        {
+            down(EMPTY);
+            down(GUARD);
+            buffer[in++ % SLOTS] = 1;
+            up(GUARD);
+            up(FULL);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < ITEMS / CONSUMERS; i++)
+        {
+            down(FULL);
+            down(GUARD);
+            consumed += buffer[out++ % SLOTS];
+            up(GUARD);
+            up(EMPTY);
+        }
+    }
+}
+
+// the same PRODUCERS and CONSUMERS threads move ITEMS items through a
+// SLOTS item buffer, first with csem and then with sem.
+// sem_timedwait() on an empty sem must time out first.
+void producer_consumer(char *s)
+{
+    int values[3] = {SLOTS, 0, 1};
+    struct sem timer;
+
+    sem_init(&timer, 0);
+    int start = uptime();
+    if (sem_timedwait(&timer, 2) != -1 || uptime() - start < 1)
+    {
+        printf("%s: sem_timedwait did not time out\n", s);
+        exit(1);
+    }
+    sem_post(&timer);
+    if (sem_timedwait(&timer, 2) != 0 || sem_trywait(&timer) != -1)
+    {
+        printf("%s: sem_timedwait did not take the count\n", s);
+        exit(1);
+    }
+
+    for (use_csem = 1; use_csem >= 0; use_csem--)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            if (!use_csem)
+                sem_init(&sems[i], values[i]);
+            else if (csem_alloc(&csems[i], values[i]) < 0)
+            {
+                printf("%s: csem_alloc failed\n", s);
+                exit(1);
+            }
+        }
+        in = out = consumed = 0;
+
+        int ticks = run_workers(s, pc_work, PRODUCERS + CONSUMERS, 1);
+        if (consumed != ITEMS)
+        {
+            printf("%s: consumed %d items, not %d\n", s, consumed, ITEMS);
+            exit(1);
+        }
+        printf("%s: %s producers %d consumers %d slots %d items %d ticks %d items per sec %s%d\n",
+               s, use_csem ? "csem" : "sem", PRODUCERS, CONSUMERS, SLOTS, ITEMS, ticks,
+               ticks > 0 ? "" : ">", ITEMS * (1000000 / US_PER_TICK) / (ticks > 0 ? ticks : 1));
+
+        if (use_csem)
+            for (int i = 0; i < 3; i++)
+                csem_free(&csems[i]);
+    }
+}
+// ------------------------------------------------------------
+
+// run each benchmark in its own process. run returns 1 if child's exit()
+// indicates success.
+int run(void f(char *), char *s)
+{
+    int pid;
+    int xstatus;
+
+    if ((pid = fork()) < 0)
+    {
+        printf("runbench: fork error\n");
+        exit(1);
+    }
+    if (pid == 0)
+    {
+        f(s);
+        exit(0);
+    }
+    wait(&xstatus);
+    if (xstatus != 0)
+        printf("bench %s: FAILED\n", s);
+    return xstatus == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    char *justone = 0;
+
+    if (argc == 2)
+    {
+        justone = argv[1];
+    }
+    else if (argc > 2)
+    {
+        printf("Usage: bench [benchname]\n");
+        exit(1);
+    }
+
+    struct bench
+    {
+        void (*f)(char *);
+        char *s;
+    } benches[] = {
+        {bsem_latency, "bsem_latency"},
+        {futex_mutex, "futex_mutex"},
+        {usync_throughput, "usync_throughput"},
+        {thread_scale, "thread_scale"},
+        {producer_consumer, "producer_consumer"},
+        {0, 0},
+    };
+
+    int fail = 0;
+    for (struct bench *b = benches; b->s != 0; b++)
+    {
+        if (justone == 0 || strcmp(b->s, justone) == 0)
+        {
+            if (!run(b->f, b->s))
+                fail = 1;
+        }
+    }
+    exit(fail);
+}
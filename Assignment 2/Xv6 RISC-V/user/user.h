@@ -39,6 +39,14 @@ void bsem_free(int);  // Task 4.1
 void bsem_up(int);    // Task 4.1
 void bsem_down(int);  // Task 4.1
 
+int sched_setaffinity(int, uint64);
+int sched_getaffinity(int, uint64 *);
+int kthread_setaffinity(int, uint64);
+int kthread_getaffinity(int, uint64 *);
+int futex(int *, int, int);
+int ksem_wait(int *, int);
+int ksem_post(int *);
+
 // ulib.c
 int stat(const char *, struct stat *);
 char *strcpy(char *, const char *);
@@ -0,0 +1,223 @@
+#include "kernel/types.h"
+#include "kernel/myParam.h"
+#include "user/user.h"
+#include "user/usync.h"
+
+#define SPIN 100      // tries at a held mutex before blocking
+#define WAKE_ALL (-1) // FUTEX_WAKE count that wakes every waiter
+
+// ------------------------- Mutexes --------------------------
+void mutex_init(struct mutex *m)
+{
+    m->state = 0;
+}
+
+int mutex_trylock(struct mutex *m)
+{
+    return __sync_bool_compare_and_swap(&m->state, 0, 1);
+}
+
+// Spin a while, as the holder may be about to release it on another
+// hart, then mark the mutex contended and sleep until it is free.
+void mutex_lock(struct mutex *m)
+{
+    int c;
+
+    for (int i = 0; i < SPIN; i++)
+    {
+        if ((c = __sync_val_compare_and_swap(&m->state, 0, 1)) == 0)
+            return;
+        if (c == 2)
+            break;
+    }
+    c = __atomic_exchange_n(&m->state, 2, __ATOMIC_ACQUIRE);
+    while (c != 0)
+    {
+        futex(&m->state, FUTEX_WAIT, 2);
+        c = __atomic_exchange_n(&m->state, 2, __ATOMIC_ACQUIRE);
+    }
+}
+
+// Only a mutex that may have waiters costs a system call.
+void mutex_unlock(struct mutex *m)
+{
+    if (__atomic_fetch_sub(&m->state, 1, __ATOMIC_RELEASE) != 1)
+    {
+        __atomic_store_n(&m->state, 0, __ATOMIC_RELEASE);
+        futex(&m->state, FUTEX_WAKE, 1);
+    }
+}
+// ------------------------------------------------------------
+
+// -------------------- Condition variables -------------------
+void cond_init(struct cond *c)
+{
+    c->seq = 0;
+}
+
+// A signal between reading seq and blocking changes seq, so futex()
+// returns at once instead of losing it. Callers recheck their
+// condition, as a wakeup may be spurious.
+void cond_wait(struct cond *c, struct mutex *m)
+{
+    int seq = __atomic_load_n(&c->seq, __ATOMIC_SEQ_CST);
+
+    mutex_unlock(m);
+    futex(&c->seq, FUTEX_WAIT, seq);
+    mutex_lock(m);
+}
+
+void cond_signal(struct cond *c)
+{
+    __atomic_fetch_add(&c->seq, 1, __ATOMIC_SEQ_CST);
+    futex(&c->seq, FUTEX_WAKE, 1);
+}
+
+void cond_broadcast(struct cond *c)
+{
+    __atomic_fetch_add(&c->seq, 1, __ATOMIC_SEQ_CST);
+    futex(&c->seq, FUTEX_WAKE, WAKE_ALL);
+}
+// ------------------------------------------------------------
+
+// ------------------- Reader-writer locks --------------------
+// Readers share the lock and a writer has it alone. New readers don't
+// wait for a waiting writer, so steady readers can starve writers.
+
+void rwlock_init(struct rwlock *rw)
+{
+    rw->state = 0;
+    rw->waiters = 0;
+}
+
+// Block while state is still s. The waiter is counted before futex()
+// checks state, and rwlock_unlock() changes state before it looks at
+// the count, so one of them sees the other.
+static void
+rwlock_block(struct rwlock *rw, int s)
+{
+    __atomic_fetch_add(&rw->waiters, 1, __ATOMIC_SEQ_CST);
+    futex(&rw->state, FUTEX_WAIT, s);
+    __atomic_fetch_sub(&rw->waiters, 1, __ATOMIC_SEQ_CST);
+}
+
+void rwlock_rdlock(struct rwlock *rw)
+{
+    for (;;)
+    {
+        int s = __atomic_load_n(&rw->state, __ATOMIC_SEQ_CST);
+        if (s >= 0)
+        {
+            if (__sync_bool_compare_and_swap(&rw->state, s, s + 1))
+                return;
+        }
+        else
+        {
+            rwlock_block(rw, s);
+        }
+    }
+}
+
+void rwlock_wrlock(struct rwlock *rw)
+{
+    for (;;)
+    {
+        if (__sync_bool_compare_and_swap(&rw->state, 0, -1))
+            return;
+        int s = __atomic_load_n(&rw->state, __ATOMIC_SEQ_CST);
+        if (s != 0)
+            rwlock_block(rw, s);
+    }
+}
+
+void rwlock_unlock(struct rwlock *rw)
+{
+    int free;
+
+    if (__atomic_load_n(&rw->state, __ATOMIC_SEQ_CST) == -1)
+    {
+        __atomic_store_n(&rw->state, 0, __ATOMIC_SEQ_CST);
+        free = 1;
+    }
+    else
+    {
+        free = __atomic_sub_fetch(&rw->state, 1, __ATOMIC_SEQ_CST) == 0;
+    }
+    if (free && __atomic_load_n(&rw->waiters, __ATOMIC_SEQ_CST) > 0)
+        futex(&rw->state, FUTEX_WAKE, WAKE_ALL);
+}
+// ------------------------------------------------------------
+
+// ------------------------- Barriers -------------------------
+void barrier_init(struct barrier *b, int n)
+{
+    b->n = n;
+    b->arrived = 0;
+    b->round = 0;
+}
+
+// Wait until b->n threads have called barrier_wait() for this round.
+// Returns 1 in the last thread to arrive and 0 in the others.
+int barrier_wait(struct barrier *b)
+{
+    int round = __atomic_load_n(&b->round, __ATOMIC_SEQ_CST);
+
+    if (__atomic_add_fetch(&b->arrived, 1, __ATOMIC_SEQ_CST) == b->n)
+    {
+        // nobody arrives for the next round before round changes.
+        __atomic_store_n(&b->arrived, 0, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&b->round, 1, __ATOMIC_SEQ_CST);
+        futex(&b->round, FUTEX_WAKE, WAKE_ALL);
+        return 1;
+    }
+    while (__atomic_load_n(&b->round, __ATOMIC_SEQ_CST) == round)
+        futex(&b->round, FUTEX_WAIT, round);
+    return 0;
+}
+// ------------------------------------------------------------
+
+// ------------------------ Semaphores ------------------------
+// The count is taken down and put up here while that needs no
+// waiting; ksem_wait() and ksem_post() block and wake.
+
+void sem_init(struct sem *s, int value)
+{
+    s->value = value;
+    s->waiters = 0;
+}
+
+// Returns 0 if it took the count down, or -1 if it was 0.
+int sem_trywait(struct sem *s)
+{
+    int v;
+
+    while ((v = __atomic_load_n(&s->value, __ATOMIC_SEQ_CST)) > 0)
+    {
+        if (__sync_bool_compare_and_swap(&s->value, v, v - 1))
+            return 0;
+    }
+    return -1;
+}
+
+int sem_wait(struct sem *s)
+{
+    if (sem_trywait(s) == 0)
+        return 0;
+    return ksem_wait(&s->value, -1);
+}
+
+// Like sem_wait(), but gives up after ticks timer ticks and returns -1.
+int sem_timedwait(struct sem *s, int ticks)
+{
+    if (sem_trywait(s) == 0)
+        return 0;
+    return ksem_wait(&s->value, ticks);
+}
+
+void sem_post(struct sem *s)
+{
+    __atomic_fetch_add(&s->value, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&s->waiters, __ATOMIC_SEQ_CST) > 0)
+        ksem_post(&s->value);
+}
+// ------------------------------------------------------------
@@ -0,0 +1,61 @@
+// Synchronization for the threads of one process, on atomic
+// instructions and futex(). The uncontended paths make no system
+// call; a thread enters the kernel only to block or to wake one up.
+// Zeroed memory is an unlocked mutex, a free rwlock, a condition
+// variable without waiters and a semaphore at 0; barriers need
+// barrier_init().
+
+struct mutex
+{
+    int state; // 0 unlocked, 1 locked, 2 locked and maybe waited for
+};
+
+struct cond
+{
+    int seq; // bumped by every signal and broadcast
+};
+
+struct rwlock
+{
+    int state;   // readers holding it, or -1 for a writer
+    int waiters; // threads blocked in futex() on state
+};
+
+struct barrier
+{
+    int n;       // threads that meet at the barrier
+    int arrived; // threads waiting for the current round
+    int round;   // bumped when the last thread arrives
+};
+
+// a counting semaphore of the kernel, see ksem_wait(). both words
+// are shared with the kernel, which wants them 8-byte aligned.
+struct sem
+{
+    int value;   // the count
+    int waiters; // threads blocked in ksem_wait()
+} __attribute__((aligned(8)));
+
+void mutex_init(struct mutex *m);
+void mutex_lock(struct mutex *m);
+int mutex_trylock(struct mutex *m);
+void mutex_unlock(struct mutex *m);
+
+void cond_init(struct cond *c);
+void cond_wait(struct cond *c, struct mutex *m);
+void cond_signal(struct cond *c);
+void cond_broadcast(struct cond *c);
+
+void rwlock_init(struct rwlock *rw);
+void rwlock_rdlock(struct rwlock *rw);
+void rwlock_wrlock(struct rwlock *rw);
+void rwlock_unlock(struct rwlock *rw);
+
+void barrier_init(struct barrier *b, int n);
+int barrier_wait(struct barrier *b);
+
+void sem_init(struct sem *s, int value);
+int sem_wait(struct sem *s);
+int sem_trywait(struct sem *s);
+int sem_timedwait(struct sem *s, int ticks);
+void sem_post(struct sem *s);
@@ -50,3 +50,13 @@ entry("bsem_alloc");    # Task 4.1
 entry("bsem_free");     # Task 4.1
 entry("bsem_up");       # Task 4.1
 entry("bsem_down");     # Task 4.1
+
+entry("sched_setaffinity");
+entry("sched_getaffinity");
+entry("kthread_setaffinity");
+entry("kthread_getaffinity");
+
+entry("futex");
+
+entry("ksem_wait");
+entry("ksem_post");
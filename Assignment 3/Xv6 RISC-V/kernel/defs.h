@@ -105,6 +105,8 @@ void            yield(void);
 int             either_copyout(int user_dst, uint64 dst, void *src, uint64 len);
 int             either_copyin(void *dst, int user_src, uint64 src, uint64 len);
 void            procdump(void);
+int             sched_setaffinity(int, uint64);
+int             sched_getaffinity(int, uint64);
 
 // swtch.S
 void            swtch(struct context*, struct context*);
@@ -119,6 +119,9 @@ allocproc(void)
 found:
   p->pid = allocpid();
   p->state = USED;
+  p->affinity = ~0UL;
+  p->last_cpu = -1;
+  p->migrations = 0;
 
   // Allocate a trapframe page.
   if((p->trapframe = (struct trapframe *)kalloc()) == 0){
@@ -163,6 +166,9 @@ freeproc(struct proc *p)
   p->chan = 0;
   p->killed = 0;
   p->xstate = 0;
+  p->affinity = 0;
+  p->last_cpu = -1;
+  p->migrations = 0;
   p->state = UNUSED;
 }
 
@@ -303,6 +309,8 @@ fork(void)
 
   safestrcpy(np->name, p->name, sizeof(p->name));
 
+  np->affinity = p->affinity;
+
   pid = np->pid;
 
   release(&np->lock);
@@ -427,6 +435,30 @@ wait(uint64 addr)
   }
 }
 
+// Stop the hart until an interrupt arrives, and count
+// the time it waited as idle time.
+// Must be called with interrupts off.
+static void
+cpu_idle(struct cpu *c)
+{
+  c->idle_start = r_time();
+  wfi();
+  c->idle += r_time() - c->idle_start;
+  c->idle_start = 0;
+}
+
+// Mask of the harts that have started scheduling.
+static uint64
+online_cpus(void)
+{
+  uint64 mask = 0;
+
+  for(int i = 0; i < NCPU; i++)
+    if(cpus[i].start != 0)
+      mask |= 1UL << i;
+  return mask;
+}
+
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
 // Scheduler never returns.  It loops, doing:
@@ -439,18 +471,28 @@ scheduler(void)
 {
   struct proc *p;
   struct cpu *c = mycpu();
+  int found;
   
   c->proc = 0;
+  c->start = r_time();
   for(;;){
     // Avoid deadlock by ensuring that devices can interrupt.
     intr_on();
 
+    // Look for work with interrupts off, so an interrupt that
+    // makes a process RUNNABLE after the search wakes up the
+    // wfi in cpu_idle() instead of being handled before it.
+    intr_off();
+    found = 0;
     for(p = proc; p < &proc[NPROC]; p++) {
       acquire(&p->lock);
-      if(p->state == RUNNABLE) {
+      if(p->state == RUNNABLE && (p->affinity & (1UL << cpuid()))) {
         // Switch to chosen process.  It is the process's job
         // to release its lock and then reacquire it
         // before jumping back to us.
+        if(p->last_cpu >= 0 && p->last_cpu != cpuid())
+          p->migrations++;
+        p->last_cpu = cpuid();
         p->state = RUNNING;
         c->proc = p;
         swtch(&c->context, &p->context);
@@ -458,9 +500,12 @@ scheduler(void)
         // Process is done running for now.
         // It should have changed its p->state before coming back.
         c->proc = 0;
+        found = 1;
       }
       release(&p->lock);
     }
+    if(!found)
+      cpu_idle(c);
   }
 }
 
@@ -650,7 +695,78 @@ procdump(void)
       state = states[p->state];
     else
       state = "???";
-    printf("%d %s %s", p->pid, state, p->name);
+    printf("%d %s %s migrations %d", p->pid, state, p->name, p->migrations);
     printf("\n");
   }
+
+  uint64 now = r_time();
+  for(int i = 0; i < NCPU; i++){
+    struct cpu *c = &cpus[i];
+    if(c->start == 0 || now == c->start)
+      continue;
+    uint64 idle = c->idle;
+    if(c->idle_start != 0)
+      idle += now - c->idle_start;
+    printf("cpu %d idle %d%%\n", i, (int)(idle * 100 / (now - c->start)));
+  }
+}
+
+// Find the process with the given pid, or the caller when pid is 0.
+// Returns with p->lock held, or 0 if there is no such process.
+static struct proc*
+find_proc(int pid)
+{
+  struct proc *p;
+
+  if(pid == 0){
+    p = myproc();
+    acquire(&p->lock);
+    return p;
+  }
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED)
+      return p;
+    release(&p->lock);
+  }
+  return 0;
+}
+
+// Let the process with the given pid, or the caller when pid is 0,
+// run only on the harts in mask, bit i for hart i.
+// Fails if mask has none of the harts that are up.
+int
+sched_setaffinity(int pid, uint64 mask)
+{
+  struct proc *p;
+  int self;
+
+  if((mask & online_cpus()) == 0)
+    return -1;
+  if((p = find_proc(pid)) == 0)
+    return -1;
+  p->affinity = mask;
+  self = p == myproc();
+  release(&p->lock);
+
+  // the caller may be on a hart it has just left.
+  if(self)
+    yield();
+  return 0;
+}
+
+// Copy the affinity mask of the process with the given pid,
+// or of the caller when pid is 0, to user address addr.
+int
+sched_getaffinity(int pid, uint64 addr)
+{
+  struct proc *p;
+  uint64 mask;
+
+  if((p = find_proc(pid)) == 0)
+    return -1;
+  mask = p->affinity & online_cpus();
+  release(&p->lock);
+
+  return copyout(myproc()->pagetable, addr, (char*)&mask, sizeof(mask));
 }
@@ -24,6 +24,9 @@ struct cpu {
   struct context context;     // swtch() here to enter scheduler().
   int noff;                   // Depth of push_off() nesting.
   int intena;                 // Were interrupts enabled before push_off()?
+  uint64 start;               // r_time() when this cpu entered scheduler()
+  uint64 idle;                // r_time() units spent waiting in wfi
+  uint64 idle_start;          // r_time() when the current wait began, or 0
 };
 
 extern struct cpu cpus[NCPU];
@@ -92,6 +95,9 @@ struct proc {
   int killed;                  // If non-zero, have been killed
   int xstate;                  // Exit status to be returned to parent's wait
   int pid;                     // Process ID
+  uint64 affinity;             // Harts p may run on, bit i for hart i
+  int last_cpu;                // Hart p last ran on, or -1
+  int migrations;              // Times p ran on a different hart than before
 
   // proc_tree_lock must be held when using this:
   struct proc *parent;         // Parent process
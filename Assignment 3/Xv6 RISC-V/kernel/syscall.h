@@ -20,3 +20,5 @@
 #define SYS_link   19
 #define SYS_mkdir  20
 #define SYS_close  21
+#define SYS_sched_setaffinity 22
+#define SYS_sched_getaffinity 23
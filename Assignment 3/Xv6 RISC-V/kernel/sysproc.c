@@ -95,3 +95,29 @@ sys_uptime(void)
   release(&tickslock);
   return xticks;
 }
+
+uint64
+sys_sched_setaffinity(void)
+{
+  int pid;
+  uint64 mask;
+
+  if(argint(0, &pid) < 0)
+    return -1;
+  if(argaddr(1, &mask) < 0)
+    return -1;
+  return sched_setaffinity(pid, mask);
+}
+
+uint64
+sys_sched_getaffinity(void)
+{
+  int pid;
+  uint64 mask;
+
+  if(argint(0, &pid) < 0)
+    return -1;
+  if(argaddr(1, &mask) < 0)
+    return -1;
+  return sched_getaffinity(pid, mask);
+}
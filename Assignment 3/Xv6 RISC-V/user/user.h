@@ -23,6 +23,8 @@ int getpid(void);
 char* sbrk(int);
 int sleep(int);
 int uptime(void);
+int sched_setaffinity(int, uint64);
+int sched_getaffinity(int, uint64*);
 
 // ulib.c
 int stat(const char*, struct stat*);